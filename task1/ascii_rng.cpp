@@ -0,0 +1,202 @@
+#include "ascii_rng.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LAB4_X86 1
+#endif
+
+namespace lab4 {
+
+namespace {
+
+constexpr std::uint16_t printable = '~' - ' ' + 1; // 95 characters
+
+std::uint64_t splitmix64(std::uint64_t& x) noexcept {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline std::uint64_t rotl(std::uint64_t x, int k) noexcept {
+    return (x << k) | (x >> (64 - k));
+}
+
+inline char to_printable(std::uint16_t bits) noexcept {
+    return static_cast<char>(' ' + ((static_cast<std::uint32_t>(bits) * printable) >> 16));
+}
+
+using State = std::uint64_t[4][4];
+using FillFn = void (*)(State&, char*, std::size_t) noexcept;
+
+// xoshiro256++ step of stream j, returns 64 output bits.
+inline std::uint64_t step_scalar(State& s, int j) noexcept {
+    const std::uint64_t result = rotl(s[0][j] + s[3][j], 23) + s[0][j];
+    const std::uint64_t t = s[1][j] << 17;
+    s[2][j] ^= s[0][j];
+    s[3][j] ^= s[1][j];
+    s[1][j] ^= s[2][j];
+    s[0][j] ^= s[3][j];
+    s[2][j] ^= t;
+    s[3][j] = rotl(s[3][j], 45);
+    return result;
+}
+
+void fill_scalar(State& s, char* out, std::size_t n) noexcept {
+    std::size_t i = 0;
+    int j = 0;
+    while (i < n) {
+        std::uint64_t bits = step_scalar(s, j);
+        j = (j + 1) & 3;
+        for (int k = 0; k < 4 && i < n; ++k, bits >>= 16) {
+            out[i++] = to_printable(static_cast<std::uint16_t>(bits));
+        }
+    }
+}
+
+#ifdef LAB4_X86
+
+inline __m128i rotl_sse2(__m128i x, int k) noexcept {
+    return _mm_or_si128(_mm_slli_epi64(x, k), _mm_srli_epi64(x, 64 - k));
+}
+
+// Two streams per register, two registers: same four streams as the scalar
+// kernel, 16 characters per step.
+void fill_sse2(State& s, char* out, std::size_t n) noexcept {
+    __m128i w[2][4];
+    for (int h = 0; h < 2; ++h) {
+        for (int k = 0; k < 4; ++k) {
+            w[h][k] = _mm_load_si128(reinterpret_cast<const __m128i*>(&s[k][2 * h]));
+        }
+    }
+    const __m128i scale = _mm_set1_epi16(static_cast<short>(printable));
+    const __m128i space = _mm_set1_epi8(' ');
+    std::size_t i = 0;
+    while (i < n) {
+        __m128i r[2];
+        for (int h = 0; h < 2; ++h) {
+            __m128i* x = w[h];
+            r[h] = _mm_add_epi64(rotl_sse2(_mm_add_epi64(x[0], x[3]), 23), x[0]);
+            const __m128i t = _mm_slli_epi64(x[1], 17);
+            x[2] = _mm_xor_si128(x[2], x[0]);
+            x[3] = _mm_xor_si128(x[3], x[1]);
+            x[1] = _mm_xor_si128(x[1], x[2]);
+            x[0] = _mm_xor_si128(x[0], x[3]);
+            x[2] = _mm_xor_si128(x[2], t);
+            x[3] = rotl_sse2(x[3], 45);
+            r[h] = _mm_mulhi_epu16(r[h], scale);
+        }
+        const __m128i chars = _mm_add_epi8(_mm_packus_epi16(r[0], r[1]), space);
+        if (n - i >= 16) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), chars);
+            i += 16;
+        } else {
+            alignas(16) char tail[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(tail), chars);
+            std::memcpy(out + i, tail, n - i);
+            i = n;
+        }
+    }
+    for (int h = 0; h < 2; ++h) {
+        for (int k = 0; k < 4; ++k) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(&s[k][2 * h]), w[h][k]);
+        }
+    }
+}
+
+__attribute__((target("avx2"))) inline __m256i rotl_avx2(__m256i x, int k) noexcept {
+    return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+__attribute__((target("avx2"))) inline __m256i step_avx2(__m256i* x) noexcept {
+    const __m256i result = _mm256_add_epi64(rotl_avx2(_mm256_add_epi64(x[0], x[3]), 23), x[0]);
+    const __m256i t = _mm256_slli_epi64(x[1], 17);
+    x[2] = _mm256_xor_si256(x[2], x[0]);
+    x[3] = _mm256_xor_si256(x[3], x[1]);
+    x[1] = _mm256_xor_si256(x[1], x[2]);
+    x[0] = _mm256_xor_si256(x[0], x[3]);
+    x[2] = _mm256_xor_si256(x[2], t);
+    x[3] = rotl_avx2(x[3], 45);
+    return result;
+}
+
+// All four streams in one register, two steps per 32 characters. packus
+// interleaves the 128-bit halves, which does not matter for random data.
+__attribute__((target("avx2"))) void fill_avx2(State& s, char* out, std::size_t n) noexcept {
+    __m256i x[4];
+    for (int k = 0; k < 4; ++k) {
+        x[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(s[k]));
+    }
+    const __m256i scale = _mm256_set1_epi16(static_cast<short>(printable));
+    const __m256i space = _mm256_set1_epi8(' ');
+    std::size_t i = 0;
+    while (i < n) {
+        const __m256i a = _mm256_mulhi_epu16(step_avx2(x), scale);
+        const __m256i b = _mm256_mulhi_epu16(step_avx2(x), scale);
+        const __m256i chars = _mm256_add_epi8(_mm256_packus_epi16(a, b), space);
+        if (n - i >= 32) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), chars);
+            i += 32;
+        } else {
+            alignas(32) char tail[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(tail), chars);
+            std::memcpy(out + i, tail, n - i);
+            i = n;
+        }
+    }
+    for (int k = 0; k < 4; ++k) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s[k]), x[k]);
+    }
+}
+
+#endif
+
+struct Kernel {
+    FillFn fill;
+    const char* name;
+};
+
+Kernel pick_kernel() noexcept {
+#ifdef LAB4_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {fill_avx2, "avx2"};
+    }
+#if defined(__SSE2__)
+    return {fill_sse2, "sse2"};
+#endif
+#endif
+    return {fill_scalar, "scalar"};
+}
+
+const Kernel& kernel() noexcept {
+    static const Kernel k = pick_kernel();
+    return k;
+}
+
+} // namespace
+
+AsciiRng::AsciiRng(std::uint64_t seed) {
+    for (int j = 0; j < 4; ++j) {
+        for (int k = 0; k < 4; ++k) {
+            state_[k][j] = splitmix64(seed);
+        }
+    }
+}
+
+void AsciiRng::fill(char* out, std::size_t n) noexcept {
+    kernel().fill(state_, out, n);
+}
+
+const char* AsciiRng::kernel_name() noexcept {
+    return kernel().name;
+}
+
+std::uint64_t racer_seed(std::uint64_t seed, int id) noexcept {
+    std::uint64_t x = seed * 0x9e3779b97f4a7c15ULL + static_cast<std::uint64_t>(id);
+    return splitmix64(x);
+}
+
+} // namespace lab4
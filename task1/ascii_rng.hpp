@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab4 {
+
+// Per-racer generator of random printable ASCII (' '..'~'). Four
+// xoshiro256++ streams run side by side so the block fill can keep them in
+// one AVX2 register (or two SSE2 registers); each 16-bit piece of output is
+// mapped to a character with a multiply-high, which is unbiased to within
+// 0.15%. The state is private to the object: no locks, no sharing.
+class AsciiRng {
+public:
+    static constexpr std::size_t block_size = 256;
+
+    explicit AsciiRng(std::uint64_t seed);
+
+    char next() noexcept {
+        if (pos_ == block_size) {
+            fill(block_, block_size);
+            pos_ = 0;
+        }
+        return block_[pos_++];
+    }
+
+    // Fills out with n random printable characters.
+    void fill(char* out, std::size_t n) noexcept;
+
+    // Kernel picked for this CPU: "avx2", "sse2" or "scalar".
+    static const char* kernel_name() noexcept;
+
+private:
+    alignas(32) std::uint64_t state_[4][4]; // [word][stream]
+    alignas(32) char block_[block_size];
+    std::size_t pos_ = block_size;
+};
+
+// Seed of racer id's generator, so racers never share a stream.
+std::uint64_t racer_seed(std::uint64_t seed, int id) noexcept;
+
+} // namespace lab4
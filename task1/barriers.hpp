@@ -0,0 +1,152 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "spin_wait.hpp"
+
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace lab4 {
+
+// Barriers below spin and then yield rather than park: what they are
+// compared on is the arrival traffic, not on sleeping.
+template <class Done>
+void spin_until(Done done) noexcept {
+    SpinWait wait(SpinWaitLock<>::max_spin_cycles);
+    while (!done()) {
+        if (!wait.spin_once()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+class StdBarrier {
+public:
+    explicit StdBarrier(int threads) : barrier_(threads) {}
+    void arrive_and_wait(int /*id*/) { barrier_.arrive_and_wait(); }
+
+private:
+    std::barrier<> barrier_;
+};
+
+// Centralized sense-reversing barrier: one shared counter, the last thread to
+// arrive resets it and flips the global sense everybody else is polling.
+class SenseBarrier {
+public:
+    explicit SenseBarrier(int threads)
+        : threads_(threads), count_(threads), local_(new Local[static_cast<std::size_t>(threads)]) {}
+
+    void arrive_and_wait(int id) noexcept {
+        const bool sense = !local_[id].sense;
+        local_[id].sense = sense;
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            count_.store(threads_, std::memory_order_relaxed);
+            sense_.store(sense, std::memory_order_release);
+        } else {
+            spin_until([&] { return sense_.load(std::memory_order_acquire) == sense; });
+        }
+    }
+
+private:
+    struct alignas(cache_line) Local {
+        bool sense = false;
+    };
+
+    const int threads_;
+    alignas(cache_line) std::atomic<int> count_;
+    alignas(cache_line) std::atomic<bool> sense_{false};
+    std::unique_ptr<Local[]> local_;
+};
+
+// Dissemination barrier (Hensgen, Finkel, Manber): in round r thread i
+// signals thread (i + 2^r) mod n and waits for (i - 2^r) mod n. No shared
+// counter, ceil(log2 n) rounds, every flag has one writer and one reader.
+class DisseminationBarrier {
+public:
+    explicit DisseminationBarrier(int threads)
+        : threads_(threads), rounds_(ceil_log2(threads)),
+          nodes_(new Node[static_cast<std::size_t>(threads)]) {}
+
+    void arrive_and_wait(int id) noexcept {
+        Node& me = nodes_[id];
+        for (int r = 0; r < rounds_; ++r) {
+            Node& partner = nodes_[(id + (1 << r)) % threads_];
+            partner.flags[me.parity][r].store(me.sense, std::memory_order_release);
+            spin_until([&] { return me.flags[me.parity][r].load(std::memory_order_acquire) == me.sense; });
+        }
+        if (me.parity == 1) {
+            me.sense = !me.sense;
+        }
+        me.parity = 1 - me.parity;
+    }
+
+private:
+    static constexpr int max_rounds = 32;
+
+    struct alignas(cache_line) Node {
+        std::atomic<bool> flags[2][max_rounds] = {};
+        int parity = 0;
+        bool sense = true;
+    };
+
+    static int ceil_log2(int n) noexcept {
+        int rounds = 0;
+        while ((1 << rounds) < n) {
+            ++rounds;
+        }
+        return rounds;
+    }
+
+    const int threads_;
+    const int rounds_;
+    std::unique_ptr<Node[]> nodes_;
+};
+
+// Tournament barrier: in round r the thread whose bit r is set reports to
+// its partner (id - 2^r) and drops out; thread 0 wins the whole tournament
+// and the wake-up travels back down the same tree.
+class TournamentBarrier {
+public:
+    explicit TournamentBarrier(int threads)
+        : threads_(threads), nodes_(new Node[static_cast<std::size_t>(threads)]) {}
+
+    void arrive_and_wait(int id) noexcept {
+        Node& me = nodes_[id];
+        const bool sense = me.sense;
+        int r = 0;
+        for (; (1 << r) < threads_; ++r) {
+            if (id & (1 << r)) {
+                nodes_[id - (1 << r)].arrived[r].store(sense, std::memory_order_release);
+                spin_until([&] { return me.wakeup.load(std::memory_order_acquire) == sense; });
+                break;
+            }
+            if (id + (1 << r) < threads_) {
+                spin_until([&] { return me.arrived[r].load(std::memory_order_acquire) == sense; });
+            }
+        }
+        // r is now the number of rounds this thread won: wake those losers.
+        while (r-- > 0) {
+            if (id + (1 << r) < threads_) {
+                nodes_[id + (1 << r)].wakeup.store(sense, std::memory_order_release);
+            }
+        }
+        me.sense = !sense;
+    }
+
+private:
+    static constexpr int max_rounds = 32;
+
+    struct alignas(cache_line) Node {
+        std::atomic<bool> arrived[max_rounds] = {};
+        std::atomic<bool> wakeup{false};
+        bool sense = true;
+    };
+
+    const int threads_;
+    std::unique_ptr<Node[]> nodes_;
+};
+
+} // namespace lab4
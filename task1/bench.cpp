@@ -0,0 +1,411 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+namespace lab4 {
+
+double BenchResult::throughput() const {
+    if (summary.median <= 0) {
+        return 0;
+    }
+    return static_cast<double>(total_chars(race)) * 1e9 / summary.median;
+}
+
+double BenchResult::overhead() const {
+    if (baseline_ns <= 0) {
+        return 0;
+    }
+    return summary.median / baseline_ns;
+}
+
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const double pos = q * static_cast<double>(sorted.size() - 1);
+    const auto lo = static_cast<std::size_t>(std::floor(pos));
+    const auto hi = static_cast<std::size_t>(std::ceil(pos));
+    const double frac = pos - static_cast<double>(lo);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+}
+
+Summary summarize(const std::vector<std::int64_t>& samples_ns, double outlier_k) {
+    Summary s;
+    s.samples = samples_ns.size();
+    if (samples_ns.empty()) {
+        return s;
+    }
+
+    std::vector<double> sorted(samples_ns.begin(), samples_ns.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    if (outlier_k > 0 && sorted.size() >= 4) {
+        const double q1 = percentile(sorted, 0.25);
+        const double q3 = percentile(sorted, 0.75);
+        const double iqr = q3 - q1;
+        const double lo = q1 - outlier_k * iqr;
+        const double hi = q3 + outlier_k * iqr;
+        sorted.erase(std::remove_if(sorted.begin(), sorted.end(),
+                                    [lo, hi](double v) { return v < lo || v > hi; }),
+                     sorted.end());
+    }
+
+    s.kept = sorted.size();
+    s.min = sorted.front();
+    s.max = sorted.back();
+    double sum = 0;
+    for (double v : sorted) {
+        sum += v;
+    }
+    s.mean = sum / static_cast<double>(sorted.size());
+    double sq = 0;
+    for (double v : sorted) {
+        sq += (v - s.mean) * (v - s.mean);
+    }
+    s.stddev = sorted.size() > 1 ? std::sqrt(sq / static_cast<double>(sorted.size() - 1)) : 0;
+    s.median = percentile(sorted, 0.5);
+    s.p90 = percentile(sorted, 0.9);
+    s.p99 = percentile(sorted, 0.99);
+    return s;
+}
+
+BenchResult run_benchmark(const PrimitiveCase& primitive, const RaceConfig& race,
+                          const BenchConfig& bench) {
+    if (bench.iterations < 1) {
+        throw std::invalid_argument("benchmark needs at least one iteration");
+    }
+
+    BenchResult result;
+    result.primitive = primitive.name;
+    result.race = race;
+
+    for (int i = 0; i < bench.warmup; ++i) {
+        primitive.run(race);
+    }
+    result.samples_ns.reserve(static_cast<std::size_t>(bench.iterations));
+    std::vector<std::int64_t> skews;
+    for (int i = 0; i < bench.iterations; ++i) {
+        RaceConfig cfg = race;
+        cfg.seed = race.seed + static_cast<unsigned>(i);
+        const RaceResult run = primitive.run(cfg);
+        if (run.finish_order.size() != static_cast<std::size_t>(cfg.threads) ||
+            std::find(run.finish_order.begin(), run.finish_order.end(), -1) != run.finish_order.end()) {
+            throw std::runtime_error(primitive.name + ": not every racer finished");
+        }
+        if (run.track.find('\0') != std::string::npos) {
+            throw std::runtime_error(primitive.name + ": characters lost on the track");
+        }
+        result.samples_ns.push_back(run.elapsed_ns);
+        skews.insert(skews.end(), run.phase_skew_ns.begin(), run.phase_skew_ns.end());
+        result.contention.merge(run.contention);
+        result.fairness.add(run.first_finish_progress, run.finish_order);
+        if (i == 0) {
+            result.perf = run.perf;
+        } else {
+            result.perf.add(run.perf);
+        }
+    }
+    result.perf.scale(1.0 / bench.iterations);
+    result.summary = summarize(result.samples_ns, bench.outlier_k);
+    result.skew = summarize(skews, 0);
+    return result;
+}
+
+void attach_baseline(std::vector<BenchResult>& results, const RaceConfig& race, const BenchConfig& bench) {
+    double baseline = 0;
+    for (const auto& r : results) {
+        if (r.primitive == "none") {
+            baseline = r.summary.median;
+        }
+    }
+    if (baseline == 0) {
+        baseline = run_benchmark(*select_cases("none").front(), race, bench).summary.median;
+    }
+    for (auto& r : results) {
+        r.baseline_ns = baseline;
+    }
+}
+
+void print_table(std::ostream& out, const std::vector<BenchResult>& results) {
+    const auto flags = out.flags();
+    out << std::left << std::setw(20) << "primitive" << std::right << std::setw(8) << "threads"
+        << std::setw(7) << "kept" << std::setw(12) << "median ms" << std::setw(12) << "p90 ms"
+        << std::setw(12) << "p99 ms" << std::setw(12) << "stddev ms" << std::setw(14) << "Mchar/s"
+        << std::setw(10) << "x none" << '\n';
+    out << std::fixed << std::setprecision(3);
+    for (const auto& r : results) {
+        const Summary& s = r.summary;
+        out << std::left << std::setw(20) << r.primitive << std::right << std::setw(8)
+            << r.race.threads << std::setw(7)
+            << (std::to_string(s.kept) + "/" + std::to_string(s.samples)) << std::setw(12)
+            << s.median / 1e6 << std::setw(12) << s.p90 / 1e6 << std::setw(12) << s.p99 / 1e6
+            << std::setw(12) << s.stddev / 1e6 << std::setw(14) << r.throughput() / 1e6;
+        if (r.baseline_ns > 0) {
+            out << std::setprecision(2) << std::setw(10) << r.overhead() << std::setprecision(3);
+        } else {
+            out << std::setw(10) << "n/a";
+        }
+        out << '\n';
+    }
+
+    bool phases = false;
+    for (const auto& r : results) {
+        phases = phases || r.skew.samples > 0;
+    }
+    if (phases) {
+        out << "\nbarrier arrival skew per lap:\n"
+            << std::left << std::setw(20) << "primitive" << std::right << std::setw(10) << "laps"
+            << std::setw(14) << "median us" << std::setw(12) << "p90 us" << std::setw(12)
+            << "p99 us" << std::setw(12) << "max us" << '\n';
+        for (const auto& r : results) {
+            if (r.skew.samples == 0) {
+                continue;
+            }
+            out << std::left << std::setw(20) << r.primitive << std::right << std::setw(10)
+                << r.skew.samples << std::setw(14) << r.skew.median / 1e3 << std::setw(12)
+                << r.skew.p90 / 1e3 << std::setw(12) << r.skew.p99 / 1e3 << std::setw(12)
+                << r.skew.max / 1e3 << '\n';
+        }
+    }
+    out.flags(flags);
+    print_fairness(out, results);
+    print_contention(out, results);
+    print_perf(out, results);
+}
+
+void print_contention(std::ostream& out, const std::vector<BenchResult>& results) {
+    bool any = false;
+    for (const auto& r : results) {
+        any = any || r.contention.acquisitions > 0;
+    }
+    if (!any) {
+        return;
+    }
+    const auto flags = out.flags();
+    out << "\ncontention (ns):\n"
+        << std::left << std::setw(20) << "primitive" << std::right << std::setw(12) << "acquires"
+        << std::setw(11) << "contended" << std::setw(10) << "wait p50" << std::setw(10)
+        << "wait p99" << std::setw(12) << "wait mean" << std::setw(10) << "hold p50"
+        << std::setw(10) << "hold p99" << std::setw(12) << "hold mean" << '\n';
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        const ContentionStats& c = r.contention;
+        if (c.acquisitions == 0) {
+            continue;
+        }
+        const double share = 100.0 * static_cast<double>(c.contended) / static_cast<double>(c.acquisitions);
+        out << std::left << std::setw(20) << r.primitive << std::right << std::setw(12)
+            << c.acquisitions << std::setw(10) << share << '%' << std::setw(10)
+            << c.wait_ns.percentile(0.5) << std::setw(10) << c.wait_ns.percentile(0.99)
+            << std::setw(12) << c.wait_ns.mean() << std::setw(10) << c.hold_ns.percentile(0.5)
+            << std::setw(10) << c.hold_ns.percentile(0.99) << std::setw(12) << c.hold_ns.mean()
+            << '\n';
+    }
+    out.flags(flags);
+}
+
+void print_fairness(std::ostream& out, const std::vector<BenchResult>& results) {
+    bool any = false;
+    for (const auto& r : results) {
+        any = any || r.fairness.runs > 0;
+    }
+    if (!any) {
+        return;
+    }
+    const auto flags = out.flags();
+    out << "\nfairness (shares at the first finish):\n"
+        << std::left << std::setw(20) << "primitive" << std::right << std::setw(11) << "jain mean"
+        << std::setw(10) << "jain min" << std::setw(12) << "order bias" << "  wins per racer\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& r : results) {
+        const Fairness& f = r.fairness;
+        if (f.runs == 0) {
+            continue;
+        }
+        out << std::left << std::setw(20) << r.primitive << std::right << std::setw(11)
+            << f.jain_mean() << std::setw(10) << f.jain_min << std::setw(12) << f.order_bias() << "  ";
+        for (std::size_t id = 0; id < f.wins.size(); ++id) {
+            out << (id == 0 ? "" : "/") << f.wins[id];
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void print_perf(std::ostream& out, const std::vector<BenchResult>& results) {
+    bool any = false;
+    for (const auto& r : results) {
+        any = any || r.perf.any();
+    }
+    if (!any) {
+        return;
+    }
+    const auto flags = out.flags();
+    auto cell = [&out](const PerfSample& p, PerfEvent e, int width) {
+        if (p.has(e)) {
+            out << std::setw(width) << p.get(e);
+        } else {
+            out << std::setw(width) << "n/a";
+        }
+    };
+    out << "\nhardware counters (mean per run):\n"
+        << std::left << std::setw(20) << "primitive" << std::right << std::setw(11) << "median ms"
+        << std::setw(14) << "cycles" << std::setw(14) << "instructions" << std::setw(7) << "IPC"
+        << std::setw(13) << "cache-miss" << std::setw(11) << "LLC-miss" << std::setw(10)
+        << "ctx-sw" << std::setw(8) << "migr" << std::setw(10) << "HITM" << '\n';
+    for (const auto& r : results) {
+        const PerfSample& p = r.perf;
+        out << std::left << std::setw(20) << r.primitive << std::right << std::fixed
+            << std::setprecision(3) << std::setw(11) << r.summary.median / 1e6 << std::setprecision(0);
+        cell(p, PerfEvent::cycles, 14);
+        cell(p, PerfEvent::instructions, 14);
+        if (p.has(PerfEvent::cycles) && p.has(PerfEvent::instructions) && p.get(PerfEvent::cycles) > 0) {
+            out << std::setprecision(2) << std::setw(7)
+                << p.get(PerfEvent::instructions) / p.get(PerfEvent::cycles) << std::setprecision(0);
+        } else {
+            out << std::setw(7) << "n/a";
+        }
+        cell(p, PerfEvent::cache_misses, 13);
+        cell(p, PerfEvent::llc_misses, 11);
+        cell(p, PerfEvent::context_switches, 10);
+        cell(p, PerfEvent::cpu_migrations, 8);
+        cell(p, PerfEvent::hitm, 10);
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_csv(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "primitive,threads,chars,samples,kept,min_ns,median_ns,p90_ns,p99_ns,max_ns,mean_ns,"
+           "stddev_ns,chars_per_sec,skew_median_ns,skew_p99_ns,acquisitions,contended,"
+           "wait_p50_ns,wait_p99_ns,hold_p50_ns,hold_p99_ns,jain_mean,jain_min,order_bias,"
+           "baseline_ns,overhead";
+    for (std::size_t e = 0; e < perf_event_count; ++e) {
+        out << ',' << perf_event_name(static_cast<PerfEvent>(e));
+    }
+    out << '\n';
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        const Summary& s = r.summary;
+        const ContentionStats& c = r.contention;
+        out << r.primitive << ',' << r.race.threads << ',' << r.race.chars << ',' << s.samples
+            << ',' << s.kept << ',' << s.min << ',' << s.median << ',' << s.p90 << ',' << s.p99
+            << ',' << s.max << ',' << s.mean << ',' << s.stddev << ',' << r.throughput() << ','
+            << r.skew.median << ',' << r.skew.p99 << ',' << c.acquisitions << ',' << c.contended
+            << ',' << c.wait_ns.percentile(0.5) << ',' << c.wait_ns.percentile(0.99) << ','
+            << c.hold_ns.percentile(0.5) << ',' << c.hold_ns.percentile(0.99) << ','
+            << std::setprecision(4) << r.fairness.jain_mean() << ',' << r.fairness.jain_min << ','
+            << r.fairness.order_bias() << ',' << std::setprecision(1) << r.baseline_ns << ','
+            << std::setprecision(3) << r.overhead() << std::setprecision(1);
+        for (std::size_t e = 0; e < perf_event_count; ++e) {
+            out << ',';
+            if (r.perf.valid[e]) {
+                out << r.perf.values[e];
+            }
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+std::string json_escape(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char c : text) {
+        switch (c) {
+        case '"': escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\t': escaped += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                escaped += buf;
+            } else {
+                escaped += c;
+            }
+        }
+    }
+    return escaped;
+}
+
+void write_json(std::ostream& out, const std::vector<BenchResult>& results, const BenchConfig& bench) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"warmup\": " << bench.warmup << ",\n  \"iterations\": " << bench.iterations
+        << ",\n  \"outlier_k\": " << bench.outlier_k << ",\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        const Summary& s = r.summary;
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(r.primitive)
+            << "\", \"threads\": " << r.race.threads << ", \"chars\": " << r.race.chars
+            << ", \"samples\": " << s.samples << ", \"kept\": " << s.kept << ", \"min_ns\": " << s.min
+            << ", \"median_ns\": " << s.median << ", \"p90_ns\": " << s.p90
+            << ", \"p99_ns\": " << s.p99 << ", \"max_ns\": " << s.max << ", \"mean_ns\": " << s.mean
+            << ", \"stddev_ns\": " << s.stddev << ", \"chars_per_sec\": " << r.throughput()
+            << ", \"skew_median_ns\": " << r.skew.median << ", \"skew_p99_ns\": " << r.skew.p99
+            << ", \"baseline_ns\": " << r.baseline_ns << ", \"overhead\": " << std::setprecision(3)
+            << r.overhead() << std::setprecision(1);
+        const ContentionStats& c = r.contention;
+        if (c.acquisitions > 0) {
+            out << ", \"contention\": {\"acquisitions\": " << c.acquisitions
+                << ", \"contended\": " << c.contended << ", \"wait_p50_ns\": "
+                << c.wait_ns.percentile(0.5) << ", \"wait_p90_ns\": " << c.wait_ns.percentile(0.9)
+                << ", \"wait_p99_ns\": " << c.wait_ns.percentile(0.99) << ", \"wait_max_ns\": "
+                << c.wait_ns.max() << ", \"wait_mean_ns\": " << c.wait_ns.mean()
+                << ", \"hold_p50_ns\": " << c.hold_ns.percentile(0.5) << ", \"hold_p90_ns\": "
+                << c.hold_ns.percentile(0.9) << ", \"hold_p99_ns\": " << c.hold_ns.percentile(0.99)
+                << ", \"hold_max_ns\": " << c.hold_ns.max() << ", \"hold_mean_ns\": "
+                << c.hold_ns.mean() << "}";
+        }
+        const Fairness& f = r.fairness;
+        if (f.runs > 0) {
+            auto list = [&out](const std::vector<std::uint64_t>& values) {
+                out << '[';
+                for (std::size_t id = 0; id < values.size(); ++id) {
+                    out << (id == 0 ? "" : ", ") << values[id];
+                }
+                out << ']';
+            };
+            out << std::setprecision(4) << ", \"fairness\": {\"jain_mean\": " << f.jain_mean()
+                << ", \"jain_min\": " << f.jain_min << ", \"order_bias\": " << f.order_bias()
+                << ", \"acquisitions\": ";
+            list(f.acquisitions);
+            out << ", \"wins\": ";
+            list(f.wins);
+            out << ", \"mean_position\": [";
+            for (std::size_t id = 0; id < f.positions.size(); ++id) {
+                out << (id == 0 ? "" : ", ") << f.mean_position(id);
+            }
+            out << "]}" << std::setprecision(1);
+        }
+        if (r.perf.any()) {
+            out << ", \"perf\": {";
+            for (std::size_t e = 0; e < perf_event_count; ++e) {
+                out << (e == 0 ? "" : ", ") << '"' << perf_event_name(static_cast<PerfEvent>(e)) << "\": ";
+                if (r.perf.valid[e]) {
+                    out << r.perf.values[e];
+                } else {
+                    out << "null";
+                }
+            }
+            out << "}";
+        }
+        out << ", \"raw_ns\": [";
+        for (std::size_t j = 0; j < r.samples_ns.size(); ++j) {
+            out << (j == 0 ? "" : ", ") << r.samples_ns[j];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
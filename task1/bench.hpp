@@ -0,0 +1,77 @@
+#pragma once
+
+#include "fairness.hpp"
+#include "race.hpp"
+#include "registry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+struct BenchConfig {
+    int warmup = 2;        // runs thrown away before measuring
+    int iterations = 15;   // measured runs per primitive
+    double outlier_k = 1.5; // Tukey fence multiplier; 0 keeps every sample
+};
+
+struct Summary {
+    std::size_t samples = 0; // measured runs
+    std::size_t kept = 0;    // runs left after outlier rejection
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    double stddev = 0;
+    double median = 0;
+    double p90 = 0;
+    double p99 = 0;
+};
+
+struct BenchResult {
+    std::string primitive;
+    RaceConfig race;
+    std::vector<std::int64_t> samples_ns;
+    Summary summary;
+    Summary skew; // per-lap arrival skew over all measured runs, phase races only
+    ContentionStats contention; // merged over measured runs when race.contention is set
+    PerfSample perf;            // mean per measured run when race.perf is set
+    Fairness fairness;          // acquisition shares and finishing positions over measured runs
+    double baseline_ns = 0;     // median of the "none" race with the same config, 0 = unknown
+
+    // Median run time as a multiple of the zero-synchronization baseline.
+    double overhead() const;
+
+    // Characters pushed through the primitive per second at the median run.
+    double throughput() const;
+};
+
+// Linear-interpolated percentile of an ascending sequence, q in [0, 1].
+double percentile(const std::vector<double>& sorted, double q);
+
+// Drops samples outside [Q1 - k*IQR, Q3 + k*IQR] and summarizes the rest.
+Summary summarize(const std::vector<std::int64_t>& samples_ns, double outlier_k);
+
+BenchResult run_benchmark(const PrimitiveCase& primitive, const RaceConfig& race,
+                          const BenchConfig& bench);
+
+// Fills baseline_ns of every result from the "none" race, reusing it when it
+// is among the results and benchmarking it with the same config otherwise.
+void attach_baseline(std::vector<BenchResult>& results, const RaceConfig& race, const BenchConfig& bench);
+
+void print_table(std::ostream& out, const std::vector<BenchResult>& results);
+// Acquisitions, contended share and wait/hold percentiles, one line per primitive.
+void print_contention(std::ostream& out, const std::vector<BenchResult>& results);
+// Counter means per run next to the median wall time.
+void print_perf(std::ostream& out, const std::vector<BenchResult>& results);
+// Jain's index of the acquisition shares, finishing-order bias and wins per racer.
+void print_fairness(std::ostream& out, const std::vector<BenchResult>& results);
+void write_csv(std::ostream& out, const std::vector<BenchResult>& results);
+void write_json(std::ostream& out, const std::vector<BenchResult>& results, const BenchConfig& bench);
+
+// Escapes a string for use inside a JSON string literal.
+std::string json_escape(const std::string& text);
+
+} // namespace lab4
@@ -0,0 +1,138 @@
+#include "co_race.hpp"
+
+#include "co_sync.hpp"
+#include "scheduler.hpp"
+
+#include <coroutine>
+#include <latch>
+#include <optional>
+#include <thread>
+
+namespace lab4 {
+
+namespace {
+
+auto acquire(CoMutex& mutex) { return mutex.lock(); }
+auto acquire(CoSemaphore& sem) { return sem.acquire(); }
+void release(CoMutex& mutex) { mutex.unlock(); }
+void release(CoSemaphore& sem) { sem.release(); }
+
+template <class Lock>
+Detached lock_racer(Lock& lock, detail::RaceBoard& board, const RaceConfig& cfg, int id, std::latch& done) {
+    AsciiRng rng(racer_seed(cfg.seed, id));
+    for (std::size_t i = 0; i < cfg.chars; ++i) {
+        const char c = rng.next();
+        co_await acquire(lock);
+        board.track[board.cursor++] = c;
+        release(lock);
+        board.advance(id);
+        board.emit(c);
+    }
+    board.record_finish(id);
+    done.count_down();
+}
+
+Detached phase_racer(CoBarrier& barrier, detail::RaceBoard& board, const RaceConfig& cfg, int id,
+                     std::vector<std::int64_t>& arrivals, std::latch& done) {
+    AsciiRng rng(racer_seed(cfg.seed, id));
+    const auto threads = static_cast<std::size_t>(cfg.threads);
+    const std::size_t lane = static_cast<std::size_t>(id) * cfg.chars;
+    std::size_t lap = 0;
+    for (std::size_t i = 0; i < cfg.chars; ++i) {
+        const char c = rng.next();
+        board.track[lane + i] = c;
+        board.advance(id);
+        board.emit(c);
+        if ((i + 1) % cfg.lap == 0 || i + 1 == cfg.chars) {
+            arrivals[lap++ * threads + static_cast<std::size_t>(id)] = detail::now_ns();
+            co_await barrier.arrive_and_wait();
+        }
+    }
+    board.record_finish(id);
+    done.count_down();
+}
+
+// Builds the pool and the primitive, creates every racer suspended, then
+// starts the clock and schedules them all. The race is over when the last
+// racer counts down; the pool is joined before the latch goes away.
+template <class Make, class Spawn>
+RaceResult run_coroutines(const RaceConfig& cfg, detail::RaceBoard& board, Make make, Spawn spawn) {
+    RaceResult result;
+    // Created before the counters, so the observers are not among the threads they count.
+    detail::ProgressReporter reporter(board, cfg.sample_us, result.progress_samples);
+    LiveView view(board.progress, cfg.chars, cfg.live_fps);
+    std::optional<PerfCounters> counters; // opened before the workers so they inherit it
+    if (cfg.perf) {
+        counters.emplace();
+    }
+    std::latch done(cfg.threads);
+    {
+        Scheduler pool(co_pool_size(cfg), cfg.cpus);
+        auto primitive = make(pool);
+        std::vector<std::coroutine_handle<>> racers;
+        racers.reserve(static_cast<std::size_t>(cfg.threads));
+        for (int id = 0; id < cfg.threads; ++id) {
+            racers.push_back(spawn(primitive, id, done).handle);
+        }
+        if (counters) {
+            counters->start();
+        }
+        reporter.begin();
+        view.begin();
+        StopWatch watch;
+        for (const auto racer : racers) {
+            pool.schedule(racer);
+        }
+        done.wait();
+        result.elapsed_ns = watch.elapsed_ns();
+        view.stop();
+        reporter.stop();
+        if (counters) {
+            result.perf = counters->stop();
+        }
+    }
+    board.finish(result);
+    return result;
+}
+
+} // namespace
+
+unsigned co_pool_size(const RaceConfig& cfg) {
+    if (cfg.workers > 0) {
+        return cfg.workers;
+    }
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+RaceResult run_co_mutex_race(const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+    return run_coroutines(
+        cfg, board, [](Scheduler& pool) { return CoMutex(pool); },
+        [&](CoMutex& mutex, int id, std::latch& done) { return lock_racer(mutex, board, cfg, id, done); });
+}
+
+RaceResult run_co_semaphore_race(const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+    return run_coroutines(
+        cfg, board, [](Scheduler& pool) { return CoSemaphore(pool, 1); },
+        [&](CoSemaphore& sem, int id, std::latch& done) { return lock_racer(sem, board, cfg, id, done); });
+}
+
+RaceResult run_co_barrier_race(const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+    const auto threads = static_cast<std::size_t>(cfg.threads);
+    std::vector<std::int64_t> arrivals(lap_count(cfg) * threads); // [lap][racer]
+    RaceResult result = run_coroutines(
+        cfg, board, [threads](Scheduler& pool) { return CoBarrier(pool, threads); },
+        [&](CoBarrier& barrier, int id, std::latch& done) {
+            return phase_racer(barrier, board, cfg, id, arrivals, done);
+        });
+    result.phase_skew_ns = detail::phase_skews(arrivals, threads);
+    return result;
+}
+
+} // namespace lab4
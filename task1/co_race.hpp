@@ -0,0 +1,25 @@
+#pragma once
+
+#include "race.hpp"
+
+namespace lab4 {
+
+// Задание 1 with coroutines instead of threads: cfg.threads racers, each a
+// coroutine, multiplexed on a work-stealing pool of co_pool_size(cfg) worker
+// threads. A racer that has to wait is suspended, not blocked, so thousands of
+// racers cost thousands of coroutine frames rather than thousands of stacks.
+// Contention histograms are not recorded for these races.
+
+// Pool size: cfg.workers, or one worker per hardware thread when it is 0.
+unsigned co_pool_size(const RaceConfig& cfg);
+
+// Shared track, one CoMutex around each character.
+RaceResult run_co_mutex_race(const RaceConfig& cfg);
+
+// Shared track, a CoSemaphore with one permit around each character.
+RaceResult run_co_semaphore_race(const RaceConfig& cfg);
+
+// Own lanes, every racer meets the others at a CoBarrier after each lap.
+RaceResult run_co_barrier_race(const RaceConfig& cfg);
+
+} // namespace lab4
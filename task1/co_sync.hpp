@@ -0,0 +1,227 @@
+#pragma once
+
+#include "futex_sync.hpp"
+#include "scheduler.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+
+namespace lab4 {
+
+// Coroutine counterparts of the Задание 1 primitives. A coroutine that has to
+// wait is suspended and queued on the primitive instead of blocking its worker;
+// whoever releases hands it to the Scheduler again. Waiters form an intrusive
+// FIFO through their awaiters, which live in the suspended coroutine frames.
+
+namespace detail {
+
+struct CoWaiter {
+    std::coroutine_handle<> handle;
+    CoWaiter* next = nullptr;
+};
+
+class CoWaitQueue {
+public:
+    bool empty() const noexcept { return head_ == nullptr; }
+
+    void push(CoWaiter* waiter) noexcept {
+        waiter->next = nullptr;
+        if (tail_ != nullptr) {
+            tail_->next = waiter;
+        } else {
+            head_ = waiter;
+        }
+        tail_ = waiter;
+    }
+
+    CoWaiter* pop() noexcept {
+        CoWaiter* waiter = head_;
+        head_ = waiter->next;
+        if (head_ == nullptr) {
+            tail_ = nullptr;
+        }
+        return waiter;
+    }
+
+    // Detaches the whole queue; walk it through CoWaiter::next.
+    CoWaiter* take_all() noexcept {
+        CoWaiter* all = head_;
+        head_ = tail_ = nullptr;
+        return all;
+    }
+
+private:
+    CoWaiter* head_ = nullptr;
+    CoWaiter* tail_ = nullptr;
+};
+
+} // namespace detail
+
+// co_await mutex.lock(); ... mutex.unlock(); Ownership is handed straight to
+// the oldest waiter, so waiters are served in FIFO order and nobody barges.
+class CoMutex {
+public:
+    explicit CoMutex(Scheduler& scheduler) : scheduler_(scheduler) {}
+
+    class LockAwaiter {
+    public:
+        explicit LockAwaiter(CoMutex& mutex) noexcept : mutex_(mutex) {}
+        bool await_ready() noexcept { return mutex_.try_lock(); }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard<FutexMutex> guard(mutex_.guard_);
+            if (!mutex_.locked_) {
+                mutex_.locked_ = true;
+                return false;
+            }
+            node_.handle = handle;
+            mutex_.waiters_.push(&node_);
+            return true;
+        }
+        void await_resume() noexcept {}
+
+    private:
+        CoMutex& mutex_;
+        detail::CoWaiter node_;
+    };
+
+    LockAwaiter lock() noexcept { return LockAwaiter(*this); }
+
+    bool try_lock() {
+        std::lock_guard<FutexMutex> guard(guard_);
+        if (locked_) {
+            return false;
+        }
+        locked_ = true;
+        return true;
+    }
+
+    void unlock() {
+        detail::CoWaiter* next = nullptr;
+        {
+            std::lock_guard<FutexMutex> guard(guard_);
+            if (waiters_.empty()) {
+                locked_ = false;
+            } else {
+                next = waiters_.pop(); // stays locked: ownership moves to next
+            }
+        }
+        if (next != nullptr) {
+            scheduler_.schedule(next->handle);
+        }
+    }
+
+private:
+    Scheduler& scheduler_;
+    FutexMutex guard_;
+    bool locked_ = false;
+    detail::CoWaitQueue waiters_;
+};
+
+// co_await sem.acquire(); ... sem.release(); A release with a waiter queued
+// passes the permit to it directly.
+class CoSemaphore {
+public:
+    CoSemaphore(Scheduler& scheduler, std::size_t permits) : scheduler_(scheduler), permits_(permits) {}
+
+    class AcquireAwaiter {
+    public:
+        explicit AcquireAwaiter(CoSemaphore& sem) noexcept : sem_(sem) {}
+        bool await_ready() noexcept { return sem_.try_acquire(); }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard<FutexMutex> guard(sem_.guard_);
+            if (sem_.permits_ > 0) {
+                --sem_.permits_;
+                return false;
+            }
+            node_.handle = handle;
+            sem_.waiters_.push(&node_);
+            return true;
+        }
+        void await_resume() noexcept {}
+
+    private:
+        CoSemaphore& sem_;
+        detail::CoWaiter node_;
+    };
+
+    AcquireAwaiter acquire() noexcept { return AcquireAwaiter(*this); }
+
+    bool try_acquire() {
+        std::lock_guard<FutexMutex> guard(guard_);
+        if (permits_ == 0) {
+            return false;
+        }
+        --permits_;
+        return true;
+    }
+
+    void release() {
+        detail::CoWaiter* next = nullptr;
+        {
+            std::lock_guard<FutexMutex> guard(guard_);
+            if (waiters_.empty()) {
+                ++permits_;
+            } else {
+                next = waiters_.pop();
+            }
+        }
+        if (next != nullptr) {
+            scheduler_.schedule(next->handle);
+        }
+    }
+
+private:
+    Scheduler& scheduler_;
+    FutexMutex guard_;
+    std::size_t permits_;
+    detail::CoWaitQueue waiters_;
+};
+
+// co_await barrier.arrive_and_wait(); The last arrival of a phase does not
+// suspend: it reschedules everybody who waited and carries on.
+class CoBarrier {
+public:
+    CoBarrier(Scheduler& scheduler, std::size_t count) : scheduler_(scheduler), count_(count) {}
+
+    class ArriveAwaiter {
+    public:
+        explicit ArriveAwaiter(CoBarrier& barrier) noexcept : barrier_(barrier) {}
+        bool await_ready() noexcept { return barrier_.count_ == 1; }
+        bool await_suspend(std::coroutine_handle<> handle) {
+            detail::CoWaiter* released = nullptr;
+            {
+                std::lock_guard<FutexMutex> guard(barrier_.guard_);
+                if (++barrier_.arrived_ < barrier_.count_) {
+                    node_.handle = handle;
+                    barrier_.waiters_.push(&node_);
+                    return true;
+                }
+                barrier_.arrived_ = 0;
+                released = barrier_.waiters_.take_all();
+            }
+            while (released != nullptr) {
+                detail::CoWaiter* next = released->next; // the node dies once its coroutine runs
+                barrier_.scheduler_.schedule(released->handle);
+                released = next;
+            }
+            return false;
+        }
+        void await_resume() noexcept {}
+
+    private:
+        CoBarrier& barrier_;
+        detail::CoWaiter node_;
+    };
+
+    ArriveAwaiter arrive_and_wait() noexcept { return ArriveAwaiter(*this); }
+
+private:
+    Scheduler& scheduler_;
+    FutexMutex guard_;
+    std::size_t count_;
+    std::size_t arrived_ = 0;
+    detail::CoWaitQueue waiters_;
+};
+
+} // namespace lab4
@@ -0,0 +1,41 @@
+#include "cohort_lock.hpp"
+
+#include "topology.hpp"
+
+#include <algorithm>
+
+#include <sched.h>
+
+namespace lab4 {
+
+CohortLock::CohortLock() {
+    const std::vector<CpuInfo> topology = read_topology();
+    std::vector<int> nodes;
+    int max_cpu = 0;
+    for (const auto& info : topology) {
+        nodes.push_back(info.node);
+        max_cpu = std::max(max_cpu, info.cpu);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+    cohort_count_ = std::max<std::size_t>(nodes.size(), 1);
+    cohorts_ = std::make_unique<Cohort[]>(cohort_count_);
+    cohort_of_cpu_.assign(static_cast<std::size_t>(max_cpu) + 1, 0);
+    for (const auto& info : topology) {
+        const auto index = std::lower_bound(nodes.begin(), nodes.end(), info.node) - nodes.begin();
+        cohort_of_cpu_[static_cast<std::size_t>(info.cpu)] = static_cast<std::uint16_t>(index);
+    }
+}
+
+// The node of the CPU the thread runs on right now. A thread migrated after
+// the lookup simply queues in its old node's cohort, which is still correct.
+std::size_t CohortLock::current_cohort() const noexcept {
+    const int cpu = sched_getcpu();
+    if (cpu < 0 || static_cast<std::size_t>(cpu) >= cohort_of_cpu_.size()) {
+        return 0;
+    }
+    return cohort_of_cpu_[static_cast<std::size_t>(cpu)];
+}
+
+} // namespace lab4
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "futex.hpp"
+#include "queue_locks.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+#include <vector>
+
+namespace lab4 {
+
+// Lock cohorting (Dice, Marathe, Shavit), C-TKT-TKT flavour: a ticket lock per
+// NUMA node in front of one global ticket lock. A thread first takes its
+// node's local lock, then the global one. On release, if another thread of the
+// same node is already queued on the local lock, the global lock is passed to
+// it along with the local one, so ownership stays inside the node for a
+// batch of up to max_batch acquisitions instead of bouncing between sockets
+// on every one. The global lock must be thread-oblivious (released by another
+// thread than the one that took it), which a ticket lock is.
+class CohortLock {
+public:
+    static constexpr std::uint32_t max_batch = 64; // local handoffs before the global lock is given up
+
+    // Maps CPUs to NUMA nodes from sysfs; one cohort per node.
+    CohortLock();
+
+    void lock() noexcept {
+        Cohort& cohort = cohorts_[current_cohort()];
+        cohort.local.lock();
+        if (!cohort.owns_global) {
+            global_.lock();
+        }
+        holder_ = &cohort;
+    }
+
+    bool try_lock() noexcept {
+        Cohort& cohort = cohorts_[current_cohort()];
+        if (!cohort.local.try_lock()) {
+            return false;
+        }
+        if (!cohort.owns_global && !global_.try_lock()) {
+            cohort.local.unlock();
+            return false;
+        }
+        holder_ = &cohort;
+        return true;
+    }
+
+    // Both levels are ticket locks, so like BasicTicketLock a timed or
+    // cancellable wait takes no ticket and retries try_lock() instead.
+    template <class Clock, class Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return lock_until(to_deadline(deadline), {});
+    }
+    template <class Rep, class Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+    // False when stop was requested before the lock was acquired.
+    bool lock(std::stop_token stop) noexcept { return lock_until(no_deadline, stop); }
+
+    void unlock() noexcept {
+        Cohort& cohort = *holder_;
+        if (cohort.local.has_waiters() && cohort.batch++ < max_batch) {
+            cohort.owns_global = true;
+        } else {
+            cohort.batch = 0;
+            cohort.owns_global = false;
+            global_.unlock();
+        }
+        cohort.local.unlock();
+    }
+
+private:
+    struct alignas(cache_line) Cohort {
+        TicketLock local;
+        bool owns_global = false; // guarded by local: the global lock came with it
+        std::uint32_t batch = 0;  // guarded by local
+    };
+
+    std::size_t current_cohort() const noexcept;
+
+    bool lock_until(Deadline deadline, const std::stop_token& stop) noexcept {
+        while (!try_lock()) {
+            if (stop.stop_requested() || std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            cpu_relax();
+        }
+        return true;
+    }
+
+    TicketLock global_;
+    std::unique_ptr<Cohort[]> cohorts_;
+    std::size_t cohort_count_ = 1;
+    std::vector<std::uint16_t> cohort_of_cpu_;
+    Cohort* holder_ = nullptr; // guarded by the lock itself
+};
+
+} // namespace lab4
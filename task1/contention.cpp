@@ -0,0 +1,73 @@
+#include "contention.hpp"
+
+#include "stopwatch.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace lab4 {
+
+void LogHistogram::merge(const LogHistogram& other) noexcept {
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.max_ > max_) {
+        max_ = other.max_;
+    }
+}
+
+double LogHistogram::mean() const noexcept {
+    return count_ == 0 ? 0 : static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+std::uint64_t LogHistogram::count_at_least(std::uint64_t threshold) const noexcept {
+    std::uint64_t count = 0;
+    for (std::size_t i = index_of(threshold); i < bucket_count; ++i) {
+        count += counts_[i];
+    }
+    return count;
+}
+
+std::uint64_t LogHistogram::percentile(double q) const noexcept {
+    if (count_ == 0) {
+        return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count_ - 1));
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+        if (rank < counts_[i]) {
+            return lower_bound_of(i);
+        }
+        rank -= counts_[i];
+    }
+    return max_;
+}
+
+void ContentionStats::merge(const ContentionStats& other) noexcept {
+    wait_ns.merge(other.wait_ns);
+    hold_ns.merge(other.hold_ns);
+    acquisitions += other.acquisitions;
+    contended += other.contended;
+}
+
+double cycle_clock_ns_per_tick() {
+    static const double ns_per_tick = [] {
+        // On x86 cycle_clock() is the same TSC StopWatch already calibrated.
+        const ClockCalibration& calibration = clock_calibration();
+        if (calibration.tsc) {
+            return calibration.ns_per_tick;
+        }
+        using clock = std::chrono::steady_clock;
+        const auto wall0 = clock::now();
+        const std::uint64_t tick0 = cycle_clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const std::uint64_t tick1 = cycle_clock();
+        const auto wall1 = clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(wall1 - wall0).count();
+        return tick1 > tick0 ? ns / static_cast<double>(tick1 - tick0) : 1.0;
+    }();
+    return ns_per_tick;
+}
+
+} // namespace lab4
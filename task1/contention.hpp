@@ -0,0 +1,88 @@
+#pragma once
+
+#include "cpu.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab4 {
+
+// HDR-style log-linear histogram: exact below 16, above that every power of
+// two is split into 16 linear sub-buckets, so any recorded value is known to
+// within about 6%. Fixed size, no allocation, cheap to record and to merge.
+class LogHistogram {
+public:
+    static constexpr int sub_bits = 4;
+    static constexpr std::size_t sub_buckets = std::size_t{1} << sub_bits;
+    static constexpr std::size_t bucket_count = 64 * sub_buckets;
+
+    void record(std::uint64_t value) noexcept {
+        ++counts_[index_of(value)];
+        ++count_;
+        sum_ += value;
+        if (value > max_) {
+            max_ = value;
+        }
+    }
+
+    void merge(const LogHistogram& other) noexcept;
+
+    std::uint64_t count() const noexcept { return count_; }
+    std::uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept;
+
+    // Smallest value of the bucket holding the q-quantile, q in [0, 1].
+    std::uint64_t percentile(double q) const noexcept;
+
+    // Recorded values in buckets from the one holding threshold upwards.
+    std::uint64_t count_at_least(std::uint64_t threshold) const noexcept;
+
+    static std::size_t index_of(std::uint64_t value) noexcept {
+        if (value < sub_buckets) {
+            return static_cast<std::size_t>(value);
+        }
+        const int msb = 63 - __builtin_clzll(value);
+        const int shift = msb - sub_bits;
+        const auto top = static_cast<std::size_t>(value >> shift); // in [16, 32)
+        return static_cast<std::size_t>(shift + 1) * sub_buckets + (top - sub_buckets);
+    }
+
+    static std::uint64_t lower_bound_of(std::size_t index) noexcept {
+        if (index < sub_buckets) {
+            return index;
+        }
+        const auto shift = static_cast<int>(index / sub_buckets) - 1;
+        const std::uint64_t top = index % sub_buckets + sub_buckets;
+        return top << shift;
+    }
+
+private:
+    std::array<std::uint64_t, bucket_count> counts_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+// What a primitive cost one racer: how long acquiring took (wait), how long
+// the lock was then held (hold), and how many acquisitions found it taken.
+// Phase races only fill wait, with the time spent inside the barrier.
+struct alignas(cache_line) ContentionStats {
+    LogHistogram wait_ns;
+    LogHistogram hold_ns;
+    std::uint64_t acquisitions = 0;
+    std::uint64_t contended = 0;
+
+    void merge(const ContentionStats& other) noexcept;
+};
+
+// Conversion factor for cycle_clock() differences, calibrated once against
+// steady_clock on first use.
+double cycle_clock_ns_per_tick();
+
+// Converts a cycle_clock() interval to whole nanoseconds.
+inline std::uint64_t ticks_to_ns(std::uint64_t ticks, double ns_per_tick) noexcept {
+    return static_cast<std::uint64_t>(static_cast<double>(ticks) * ns_per_tick);
+}
+
+} // namespace lab4
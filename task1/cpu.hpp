@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace lab4 {
+
+// Size used to keep independently written words on separate cache lines.
+inline constexpr std::size_t cache_line = 64;
+
+// Spin-loop hint: PAUSE on x86, YIELD on ARM, nothing elsewhere.
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Cheap monotonic tick counter for short intervals: TSC cycles on x86,
+// steady_clock nanoseconds elsewhere. Only differences are meaningful.
+inline std::uint64_t cycle_clock() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+} // namespace lab4
@@ -0,0 +1,63 @@
+#include "fairness.hpp"
+
+#include <algorithm>
+
+namespace lab4 {
+
+double jain_index(const std::vector<double>& shares) {
+    double sum = 0;
+    double squares = 0;
+    for (double x : shares) {
+        sum += x;
+        squares += x * x;
+    }
+    if (squares == 0) {
+        return 1;
+    }
+    return sum * sum / (static_cast<double>(shares.size()) * squares);
+}
+
+void Fairness::add(const std::vector<std::size_t>& progress, const std::vector<int>& order) {
+    const std::size_t racers = progress.size();
+    if (acquisitions.size() < racers) {
+        acquisitions.resize(racers);
+        positions.resize(racers);
+        wins.resize(racers);
+    }
+    std::vector<double> shares(progress.begin(), progress.end());
+    const double jain = jain_index(shares);
+    jain_sum += jain;
+    jain_min = std::min(jain_min, jain);
+    for (std::size_t id = 0; id < racers; ++id) {
+        acquisitions[id] += progress[id];
+    }
+    for (std::size_t pos = 0; pos < order.size(); ++pos) {
+        const auto id = static_cast<std::size_t>(order[pos]);
+        positions[id] += pos;
+        wins[id] += pos == 0 ? 1 : 0;
+    }
+    ++runs;
+}
+
+double Fairness::jain_mean() const noexcept {
+    return runs == 0 ? 0 : jain_sum / static_cast<double>(runs);
+}
+
+double Fairness::mean_position(std::size_t racer) const noexcept {
+    return runs == 0 ? 0 : static_cast<double>(positions[racer]) / static_cast<double>(runs);
+}
+
+double Fairness::order_bias() const noexcept {
+    if (runs == 0 || positions.size() < 2) {
+        return 0;
+    }
+    double lo = mean_position(0);
+    double hi = lo;
+    for (std::size_t id = 1; id < positions.size(); ++id) {
+        lo = std::min(lo, mean_position(id));
+        hi = std::max(hi, mean_position(id));
+    }
+    return (hi - lo) / static_cast<double>(positions.size() - 1);
+}
+
+} // namespace lab4
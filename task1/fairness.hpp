@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lab4 {
+
+// Jain's fairness index (sum x)^2 / (n * sum x^2): 1 when every share is
+// equal, 1/n when one participant got everything.
+double jain_index(const std::vector<double>& shares);
+
+// Who got the primitive while everybody still wanted it. Every racer places
+// the same number of characters in the end, so the shares are taken at the
+// moment the first racer finishes; a lock that lets one thread barge in over
+// and over shows up as a low index and as the same racer finishing first.
+struct Fairness {
+    std::size_t runs = 0;
+    std::vector<std::uint64_t> acquisitions; // per racer, summed over runs, until the first finish
+    std::vector<std::uint64_t> positions;    // per racer, summed finishing positions, 0 = first
+    std::vector<std::uint64_t> wins;         // per racer, runs it finished first
+    double jain_sum = 0;
+    double jain_min = 1;
+
+    // progress: characters per racer at the first finish; order: finish order of the run.
+    void add(const std::vector<std::size_t>& progress, const std::vector<int>& order);
+
+    double jain_mean() const noexcept;
+    double mean_position(std::size_t racer) const noexcept;
+    // Spread of the mean finishing positions scaled to [0, 1]: 0 when every
+    // racer finishes in every position equally often, 1 when the order never
+    // changes between runs.
+    double order_bias() const noexcept;
+};
+
+} // namespace lab4
@@ -0,0 +1,109 @@
+#include "false_sharing.hpp"
+
+#include <iomanip>
+#include <ostream>
+
+namespace lab4 {
+
+namespace {
+
+// HITM as a printable cell; n/a when the PMU does not offer it.
+void hitm_cell(std::ostream& out, const PerfSample& perf, int width) {
+    if (perf.has(PerfEvent::hitm)) {
+        out << std::setw(width) << std::setprecision(0) << perf.get(PerfEvent::hitm);
+    } else {
+        out << std::setw(width) << "n/a";
+    }
+}
+
+void hitm_value(std::ostream& out, const PerfSample& perf, const char* missing) {
+    if (perf.has(PerfEvent::hitm)) {
+        out << perf.get(PerfEvent::hitm);
+    } else {
+        out << missing;
+    }
+}
+
+} // namespace
+
+double LayoutComparison::slowdown() const {
+    if (padded.summary.median <= 0) {
+        return 0;
+    }
+    return packed.summary.median / padded.summary.median;
+}
+
+std::vector<LayoutComparison> run_layout_study(const std::vector<const PrimitiveCase*>& cases,
+                                               const RaceConfig& race, const BenchConfig& bench) {
+    RaceConfig padded = race;
+    padded.layout = Layout::padded;
+    padded.perf = true;
+    RaceConfig packed = padded;
+    packed.layout = Layout::packed;
+
+    std::vector<LayoutComparison> study;
+    for (const PrimitiveCase* c : cases) {
+        LayoutComparison comparison;
+        comparison.padded = run_benchmark(*c, padded, bench);
+        comparison.packed = run_benchmark(*c, packed, bench);
+        study.push_back(std::move(comparison));
+    }
+    return study;
+}
+
+void print_layout_study(std::ostream& out, const std::vector<LayoutComparison>& study) {
+    const auto flags = out.flags();
+    out << "per-racer state padded to " << destructive_interference() << " bytes vs packed:\n"
+        << std::left << std::setw(20) << "primitive" << std::right << std::setw(8) << "threads"
+        << std::setw(12) << "padded ms" << std::setw(12) << "packed ms" << std::setw(10) << "slowdown"
+        << std::setw(14) << "HITM padded" << std::setw(14) << "HITM packed" << '\n';
+    out << std::fixed;
+    for (const auto& c : study) {
+        out << std::left << std::setw(20) << c.padded.primitive << std::right << std::setw(8)
+            << c.padded.race.threads << std::setprecision(3) << std::setw(12)
+            << c.padded.summary.median / 1e6 << std::setw(12) << c.packed.summary.median / 1e6
+            << std::setprecision(2) << std::setw(9) << c.slowdown() << 'x';
+        hitm_cell(out, c.padded.perf, 14);
+        hitm_cell(out, c.packed.perf, 14);
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_layout_csv(std::ostream& out, const std::vector<LayoutComparison>& study) {
+    out << "primitive,threads,padded_median_ns,packed_median_ns,slowdown,padded_hitm,packed_hitm\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& c : study) {
+        out << c.padded.primitive << ',' << c.padded.race.threads << ',' << c.padded.summary.median << ','
+            << c.packed.summary.median << ',' << std::setprecision(3) << c.slowdown()
+            << std::setprecision(1) << ',';
+        hitm_value(out, c.padded.perf, "");
+        out << ',';
+        hitm_value(out, c.packed.perf, "");
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_layout_json(std::ostream& out, const std::vector<LayoutComparison>& study) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"interference_bytes\": " << destructive_interference() << ",\n  \"layouts\": [";
+    for (std::size_t i = 0; i < study.size(); ++i) {
+        const LayoutComparison& c = study[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(c.padded.primitive)
+            << "\", \"threads\": " << c.padded.race.threads
+            << ", \"padded_median_ns\": " << c.padded.summary.median
+            << ", \"packed_median_ns\": " << c.packed.summary.median << ", \"slowdown\": "
+            << std::setprecision(3) << c.slowdown() << std::setprecision(1) << ", \"padded_hitm\": ";
+        hitm_value(out, c.padded.perf, "null");
+        out << ", \"packed_hitm\": ";
+        hitm_value(out, c.packed.perf, "null");
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <iosfwd>
+#include <vector>
+
+namespace lab4 {
+
+// Primitives the layout study runs when no --primitives filter is given: the
+// baseline, where the progress counters are the only shared memory, and the
+// two races whose per-racer state is written on every character.
+inline constexpr const char* layout_study_default = "none,futex-mutex,flat-combining";
+
+// The same benchmark with per-racer state padded and packed.
+struct LayoutComparison {
+    BenchResult padded;
+    BenchResult packed;
+
+    // Packed median over padded median: > 1 is what false sharing costs.
+    double slowdown() const;
+};
+
+// Runs every case twice, with perf counters on so HITM can be reported.
+std::vector<LayoutComparison> run_layout_study(const std::vector<const PrimitiveCase*>& cases,
+                                               const RaceConfig& race, const BenchConfig& bench);
+
+void print_layout_study(std::ostream& out, const std::vector<LayoutComparison>& study);
+void write_layout_csv(std::ostream& out, const std::vector<LayoutComparison>& study);
+void write_layout_json(std::ostream& out, const std::vector<LayoutComparison>& study);
+
+} // namespace lab4
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "layout.hpp"
+#include "spin_wait.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace lab4 {
+
+// Flat combining (Hendler, Incze, Shavit, Tzafrir): instead of every thread
+// taking the lock for its own update, each one publishes the update in its
+// own slot (a cache line of its own unless the layout is packed) and
+// whoever gets the lock applies all pending updates in one pass. The shared
+// state stays in the combiner's cache for the whole batch, and the other
+// threads only ever touch their own slot until the combiner clears it.
+//
+// Apply is called as apply(request, slot) by the combining thread only.
+template <class Request, class Apply>
+class FlatCombiner {
+public:
+    FlatCombiner(std::size_t slots, Layout layout, Apply apply) : slots_(slots, layout), apply_(std::move(apply)) {}
+
+    // Publishes a request from the given slot and returns once it has been
+    // applied, by this thread or by another combiner. Returns false when
+    // another thread applied it.
+    bool execute(std::size_t slot, const Request& request) noexcept {
+        Slot& mine = slots_[slot];
+        mine.request = request;
+        mine.pending.store(true, std::memory_order_release);
+        SpinWait wait(SpinWaitLock<>::max_spin_cycles);
+        for (;;) {
+            // Checked first: once another combiner has applied the request,
+            // taking the lock would only buy an empty pass.
+            if (!mine.pending.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (!locked_.load(std::memory_order_relaxed) &&
+                !locked_.exchange(true, std::memory_order_acquire)) {
+                // The previous combiner may have served us just before it let go.
+                const bool ours = mine.pending.load(std::memory_order_acquire);
+                if (ours) {
+                    combine();
+                }
+                locked_.store(false, std::memory_order_release);
+                return ours;
+            }
+            if (!wait.spin_once()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<bool> pending{false};
+        Request request{};
+    };
+
+    void combine() noexcept {
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            Slot& slot = slots_[i];
+            if (slot.pending.load(std::memory_order_acquire)) {
+                apply_(slot.request, i);
+                slot.pending.store(false, std::memory_order_release);
+            }
+        }
+    }
+
+    PerThread<Slot> slots_; // padded: one cache line per racer
+    Apply apply_;
+    alignas(cache_line) std::atomic<bool> locked_{false};
+};
+
+} // namespace lab4
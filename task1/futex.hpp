@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <type_traits>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lab4 {
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "futex word must be a plain 32-bit integer");
+
+// Sleeps while word == expected. Spurious returns (EAGAIN, EINTR) are possible,
+// callers always re-check their condition in a loop.
+inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            nullptr, nullptr, 0);
+}
+
+// Absolute deadline of a timed wait. libstdc++'s steady_clock reads
+// CLOCK_MONOTONIC, the clock FUTEX_WAIT_BITSET measures absolute timeouts in.
+using Deadline = std::chrono::steady_clock::time_point;
+inline constexpr Deadline no_deadline = Deadline::max();
+
+template <class Clock, class Duration>
+Deadline to_deadline(const std::chrono::time_point<Clock, Duration>& when) noexcept {
+    if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>) {
+        return std::chrono::time_point_cast<Deadline::duration>(when);
+    } else {
+        return std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<Deadline::duration>(when - Clock::now());
+    }
+}
+
+// futex_wait() that gives up at deadline. The kernel sleeps until the absolute
+// time itself, so there is no polling and no drift from re-arming a relative
+// timeout after spurious returns. Returns false once the deadline has passed.
+inline bool futex_wait_until(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                             Deadline deadline) noexcept {
+    if (deadline == no_deadline) {
+        futex_wait(word, expected);
+        return true;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    if (ns <= 0) {
+        return false;
+    }
+    const timespec at{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+    const long rc = syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_BITSET_PRIVATE,
+                            expected, &at, nullptr, FUTEX_BITSET_MATCH_ANY);
+    return rc == 0 || errno != ETIMEDOUT;
+}
+
+// Wakes up to count threads sleeping on word.
+inline void futex_wake(std::atomic<std::uint32_t>& word, int count) noexcept {
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr,
+            nullptr, 0);
+}
+
+} // namespace lab4
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "futex.hpp"
+#include "orderings.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <stop_token>
+
+namespace lab4 {
+
+// Drepper's futex mutex: 0 free, 1 locked, 2 locked and somebody may sleep.
+// Uncontended lock and unlock are a single atomic each and never enter the
+// kernel; the syscall is only made when the state says there are sleepers.
+//
+// Timed and cancellable acquisitions sleep with an absolute deadline on a
+// separate wake sequence, as FutexSemaphore does. A stop request and every
+// contended unlock that sees such a sleeper bump it, so neither can be lost
+// between the waiter's last check and its futex_wait, however often other
+// contenders rewrite the state in between.
+template <OrderingPolicy Order = AcqRelOrdering>
+class BasicFutexMutex {
+public:
+    void lock() noexcept {
+        if (!try_lock()) {
+            lock_contended();
+        }
+    }
+
+    bool try_lock() noexcept {
+        std::uint32_t expected = unlocked;
+        if (!state_.compare_exchange_strong(expected, locked, Order::acquire, Order::plain)) {
+            return false;
+        }
+        Order::after_acquire();
+        return true;
+    }
+
+    template <class Clock, class Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return try_lock() || lock_contended(to_deadline(deadline), {});
+    }
+
+    template <class Rep, class Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // False when stop was requested before the lock was acquired.
+    bool lock(std::stop_token stop) noexcept { return try_lock() || lock_contended(no_deadline, stop); }
+
+    void unlock() noexcept {
+        Order::before_release();
+        if (state_.exchange(unlocked, Order::release) == contended) {
+            futex_wake(state_, 1);
+            // Pairs with the seq_cst count and exchange in lock_contended(Deadline, ...):
+            // either this load sees the timed waiter or its exchange sees the lock free.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (timed_waiters_.load(std::memory_order_seq_cst) > 0) {
+                wake_seq_.fetch_add(1, std::memory_order_seq_cst);
+                futex_wake(wake_seq_, 1);
+            }
+        }
+    }
+
+    // Slow path: marks the mutex contended and sleeps until it is handed over.
+    void lock_contended() noexcept {
+        while (state_.exchange(contended, Order::acquire) != unlocked) {
+            futex_wait(state_, contended);
+        }
+        Order::after_acquire();
+    }
+
+    // Slow path with a deadline and a stop token; false when either fires first.
+    bool lock_contended(Deadline deadline, std::stop_token stop) noexcept {
+        auto poke = [this] {
+            wake_seq_.fetch_add(1, std::memory_order_seq_cst);
+            futex_wake(wake_seq_, INT_MAX);
+        };
+        std::stop_callback<decltype(poke)> on_stop(stop, poke);
+        timed_waiters_.fetch_add(1, std::memory_order_seq_cst);
+        bool acquired = false;
+        for (;;) {
+            const std::uint32_t seen = wake_seq_.load(std::memory_order_seq_cst);
+            if (stop.stop_requested()) {
+                break;
+            }
+            if (state_.exchange(contended, std::memory_order_seq_cst) == unlocked) {
+                acquired = true;
+                break;
+            }
+            if (!futex_wait_until(wake_seq_, seen, deadline)) {
+                break;
+            }
+        }
+        // An unlock wakes one timed waiter; if that was us and we give up, the
+        // wake-up goes on to the next one instead of leaving it asleep.
+        if (timed_waiters_.fetch_sub(1, std::memory_order_seq_cst) > 1 && !acquired) {
+            wake_seq_.fetch_add(1, std::memory_order_seq_cst);
+            futex_wake(wake_seq_, 1);
+        }
+        if (acquired) {
+            Order::after_acquire();
+        }
+        return acquired;
+    }
+
+    bool is_locked() const noexcept { return state_.load(Order::plain) != unlocked; }
+
+private:
+    static constexpr std::uint32_t unlocked = 0;
+    static constexpr std::uint32_t locked = 1;
+    static constexpr std::uint32_t contended = 2;
+
+    std::atomic<std::uint32_t> state_{unlocked};
+    std::atomic<std::uint32_t> timed_waiters_{0}; // sleeping, or about to, on wake_seq_
+    std::atomic<std::uint32_t> wake_seq_{0};
+};
+
+using FutexMutex = BasicFutexMutex<>;
+
+// Counting semaphore on a word holding the number of permits. The waiter
+// counter lets release() skip the syscall when nobody sleeps; both sides use
+// seq_cst so a release cannot miss a waiter that is about to park. Waiters
+// sleep on a separate wake sequence rather than the permit count: a release
+// and a stop request both bump it, so neither can be lost between the
+// waiter's last check and its futex_wait.
+class FutexSemaphore {
+public:
+    explicit FutexSemaphore(std::uint32_t permits) noexcept : permits_(permits) {}
+
+    void acquire() noexcept {
+        if (!try_acquire()) {
+            acquire_slow(no_deadline, {});
+        }
+    }
+
+    template <class Clock, class Duration>
+    bool try_acquire_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return try_acquire() || acquire_slow(to_deadline(deadline), {});
+    }
+
+    template <class Rep, class Period>
+    bool try_acquire_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_acquire_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // False when stop was requested before a permit was taken.
+    bool acquire(std::stop_token stop) noexcept { return try_acquire() || acquire_slow(no_deadline, stop); }
+
+    bool try_acquire() noexcept {
+        std::uint32_t permits = permits_.load(std::memory_order_seq_cst);
+        while (permits > 0) {
+            if (permits_.compare_exchange_weak(permits, permits - 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release(std::uint32_t count = 1) noexcept {
+        permits_.fetch_add(count, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            wake_seq_.fetch_add(1, std::memory_order_seq_cst);
+            futex_wake(wake_seq_, static_cast<int>(count));
+        }
+    }
+
+private:
+    bool acquire_slow(Deadline deadline, std::stop_token stop) noexcept {
+        auto poke = [this] {
+            wake_seq_.fetch_add(1, std::memory_order_seq_cst);
+            futex_wake(wake_seq_, INT_MAX);
+        };
+        std::stop_callback<decltype(poke)> on_stop(stop, poke);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        bool acquired = false;
+        for (;;) {
+            const std::uint32_t seen = wake_seq_.load(std::memory_order_seq_cst);
+            acquired = try_acquire();
+            if (acquired || stop.stop_requested() || !futex_wait_until(wake_seq_, seen, deadline)) {
+                break;
+            }
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return acquired;
+    }
+
+    std::atomic<std::uint32_t> permits_;
+    std::atomic<std::uint32_t> waiters_{0};
+    std::atomic<std::uint32_t> wake_seq_{0};
+};
+
+} // namespace lab4
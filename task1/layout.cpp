@@ -0,0 +1,29 @@
+#include "layout.hpp"
+
+#include <stdexcept>
+
+namespace lab4 {
+
+std::size_t destructive_interference() noexcept {
+#ifdef __cpp_lib_hardware_interference_size
+    return std::hardware_destructive_interference_size;
+#else
+    return 64;
+#endif
+}
+
+const char* layout_name(Layout layout) {
+    return layout == Layout::packed ? "packed" : "padded";
+}
+
+Layout parse_layout(const std::string& text) {
+    if (text == "padded") {
+        return Layout::padded;
+    }
+    if (text == "packed") {
+        return Layout::packed;
+    }
+    throw std::invalid_argument("layout must be padded or packed: " + text);
+}
+
+} // namespace lab4
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <string>
+
+namespace lab4 {
+
+// How per-racer state is laid out in memory.
+enum class Layout {
+    padded, // every racer's element on its own destructive-interference block
+    packed, // elements back to back, several racers per cache line
+};
+
+// std::hardware_destructive_interference_size. Read in a .cpp: its value
+// follows the compiler's -mtune, so it must not leak into a header's ABI.
+std::size_t destructive_interference() noexcept;
+
+const char* layout_name(Layout layout);
+
+// Throws std::invalid_argument unless text is "padded" or "packed".
+Layout parse_layout(const std::string& text);
+
+// Fixed-size array of per-racer state whose layout is chosen at run time,
+// so the same race can be run with and without false sharing.
+template <class T>
+class PerThread {
+public:
+    PerThread(std::size_t count, Layout layout)
+        : count_(count), stride_(sizeof(T)), align_(alignof(T)) {
+        if (layout == Layout::padded) {
+            const std::size_t block = destructive_interference();
+            stride_ = (sizeof(T) + block - 1) / block * block;
+            align_ = align_ > block ? align_ : block;
+        }
+        storage_ = static_cast<std::byte*>(::operator new(count_ * stride_, std::align_val_t{align_}));
+        for (std::size_t i = 0; i < count_; ++i) {
+            ::new (storage_ + i * stride_) T();
+        }
+    }
+
+    ~PerThread() {
+        for (std::size_t i = 0; i < count_; ++i) {
+            (*this)[i].~T();
+        }
+        ::operator delete(storage_, std::align_val_t{align_});
+    }
+
+    PerThread(const PerThread&) = delete;
+    PerThread& operator=(const PerThread&) = delete;
+
+    T& operator[](std::size_t i) noexcept { return *std::launder(reinterpret_cast<T*>(storage_ + i * stride_)); }
+    const T& operator[](std::size_t i) const noexcept {
+        return *std::launder(reinterpret_cast<const T*>(storage_ + i * stride_));
+    }
+
+    std::size_t size() const noexcept { return count_; }
+    std::size_t stride() const noexcept { return stride_; }
+
+private:
+    std::size_t count_;
+    std::size_t stride_;
+    std::size_t align_;
+    std::byte* storage_;
+};
+
+} // namespace lab4
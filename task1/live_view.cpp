@@ -0,0 +1,113 @@
+#include "live_view.hpp"
+
+#include "futex.hpp"
+
+#include <cerrno>
+#include <cstdio>
+
+#include <unistd.h>
+
+namespace lab4 {
+
+LiveView::LiveView(const PerThread<std::atomic<std::size_t>>& progress, std::size_t chars, unsigned fps)
+    : progress_(progress), chars_(chars), period_(fps == 0 ? 0 : 1000000000 / fps) {
+    if (fps == 0) {
+        return;
+    }
+    // Sized once, so composing a frame never allocates while the racers run.
+    for (std::vector<std::size_t>& sample : samples_) {
+        sample.resize(progress_.size());
+    }
+    frame_.reserve((progress_.size() + 1) * (bar_width + 64));
+    std::fflush(stdout);
+    thread_ = std::thread([this] { render(); });
+}
+
+void LiveView::begin() noexcept {
+    if (!thread_.joinable()) {
+        return;
+    }
+    phase_.store(running, std::memory_order_release);
+    futex_wake(phase_, 1);
+}
+
+void LiveView::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    const bool begun = phase_.exchange(stopping, std::memory_order_acq_rel) == running;
+    futex_wake(phase_, 1);
+    thread_.join();
+    if (begun) {
+        draw(true);
+    }
+}
+
+void LiveView::render() {
+    while (phase_.load(std::memory_order_acquire) == idle) {
+        futex_wait(phase_, idle);
+    }
+    watch_.restart();
+    Deadline next = std::chrono::steady_clock::now();
+    while (phase_.load(std::memory_order_acquire) == running) {
+        draw();
+        next += period_;
+        const Deadline now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now + period_; // the terminal fell behind: drop frames instead of bunching them up
+        }
+        while (phase_.load(std::memory_order_acquire) == running && futex_wait_until(phase_, running, next)) {
+        }
+    }
+}
+
+// The last frame is written even when nobody moved, so it shows the final time.
+void LiveView::draw(bool last) {
+    std::vector<std::size_t>& sample = samples_[back_];
+    for (std::size_t id = 0; id < sample.size(); ++id) {
+        sample[id] = progress_[id].load(std::memory_order_relaxed);
+    }
+    if (drawn_ && !last && sample == samples_[back_ ^ 1]) {
+        return;
+    }
+    compose(sample);
+    const char* data = frame_.data();
+    std::size_t size = frame_.size();
+    while (size > 0) {
+        const ssize_t written = ::write(STDOUT_FILENO, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // a broken console only loses the picture
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    drawn_ = true;
+    back_ ^= 1;
+}
+
+void LiveView::compose(const std::vector<std::size_t>& sample) {
+    frame_.clear();
+    char line[96];
+    if (drawn_) {
+        // Back to the top of the previous frame; every line has a fixed width.
+        std::snprintf(line, sizeof line, "\x1b[%zuA\r", sample.size() + 1);
+        frame_ += line;
+    }
+    std::snprintf(line, sizeof line, "%10.3f ms\n", watch_.elapsed_ms());
+    frame_ += line;
+    for (std::size_t id = 0; id < sample.size(); ++id) {
+        const std::size_t done = sample[id] < chars_ ? sample[id] : chars_;
+        const std::size_t filled = chars_ == 0 ? bar_width : done * bar_width / chars_;
+        std::snprintf(line, sizeof line, "racer %3zu [", id);
+        frame_ += line;
+        frame_.append(filled, '#');
+        frame_.append(bar_width - filled, '.');
+        std::snprintf(line, sizeof line, "] %10zu/%zu%s\n", done, chars_, done == chars_ ? " done" : "     ");
+        frame_ += line;
+    }
+}
+
+} // namespace lab4
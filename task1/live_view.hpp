@@ -0,0 +1,63 @@
+#pragma once
+
+#include "layout.hpp"
+#include "stopwatch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lab4 {
+
+// Live view of a race: a renderer thread draws one bar per racer at a fixed
+// frame rate. It only reads the racers' progress counters, with relaxed
+// loads, so the racers never wait for it and never see a lock or a
+// syscall of its making. The progress is sampled into the back buffer and
+// compared with the front one, which holds what is on screen; when no racer
+// has moved nothing is written, otherwise the frame goes to the terminal
+// with a single write(2) and the buffers are swapped. Frames the terminal is
+// too slow for are dropped, not queued. The thread is created idle before
+// the race sets up perf counters, so it is not among the inherited threads
+// they count, and only starts drawing at begin().
+class LiveView {
+public:
+    static constexpr std::size_t bar_width = 40;
+
+    // Draws to stdout once begun; does nothing when fps is 0.
+    LiveView(const PerThread<std::atomic<std::size_t>>& progress, std::size_t chars, unsigned fps);
+    ~LiveView() { stop(); }
+
+    LiveView(const LiveView&) = delete;
+    LiveView& operator=(const LiveView&) = delete;
+
+    // Starts drawing, with the clock on the first frame starting now.
+    void begin() noexcept;
+    // Stops the renderer and draws the final frame if it had begun.
+    void stop();
+
+private:
+    void render();
+    void draw(bool last = false);
+    void compose(const std::vector<std::size_t>& sample);
+
+    const PerThread<std::atomic<std::size_t>>& progress_;
+    std::size_t chars_;
+    std::chrono::nanoseconds period_;
+    StopWatch watch_;
+    std::vector<std::size_t> samples_[2]; // progress in the frame on screen and in the next one
+    std::string frame_;
+    int back_ = 0;
+    bool drawn_ = false;
+    static constexpr std::uint32_t idle = 0;
+    static constexpr std::uint32_t running = 1;
+    static constexpr std::uint32_t stopping = 2;
+
+    std::atomic<std::uint32_t> phase_{idle}; // futex word: the renderer sleeps on it before and between frames
+    std::thread thread_;
+};
+
+} // namespace lab4
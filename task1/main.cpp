@@ -0,0 +1,267 @@
+#include "ascii_rng.hpp"
+#include "bench.hpp"
+#include "false_sharing.hpp"
+#include "memory_orders.hpp"
+#include "options.hpp"
+#include "paths.hpp"
+#include "pingpong.hpp"
+#include "registry.hpp"
+#include "stopwatch.hpp"
+#include "stress.hpp"
+#include "sweep.hpp"
+#include "timeouts.hpp"
+#include "topology.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace lab4;
+
+namespace {
+
+template <class Writer>
+void write_file(const std::string& path, Writer writer) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    writer(out);
+}
+
+void run_race_mode(const Options& opt) {
+    for (const PrimitiveCase* c : select_cases(opt.primitives)) {
+        std::cout << "== " << c->name << " (" << c->description << ")\n" << std::flush;
+        const RaceResult result = c->run(opt.race);
+        if (opt.race.echo) {
+            std::cout << '\n';
+        }
+        std::cout << "finish order:";
+        for (int id : result.finish_order) {
+            std::cout << ' ' << id;
+        }
+        std::cout << "\nacquisitions before the first finish:";
+        for (std::size_t n : result.first_finish_progress) {
+            std::cout << ' ' << n;
+        }
+        const std::vector<double> shares(result.first_finish_progress.begin(),
+                                         result.first_finish_progress.end());
+        std::cout << " (Jain " << jain_index(shares) << ')';
+        std::cout << "\ntime: " << static_cast<double>(result.elapsed_ns) / 1e6 << " ms\n";
+        if (!result.progress_samples.empty()) {
+            std::cout << "progress samples:\n";
+            for (const ProgressSample& sample : result.progress_samples) {
+                std::cout << "  " << static_cast<double>(sample.elapsed_ns) / 1e6 << " ms:";
+                for (std::size_t n : sample.progress) {
+                    std::cout << ' ' << n;
+                }
+                std::cout << '\n';
+            }
+        }
+        if (opt.race.contention || opt.race.perf) {
+            BenchResult single;
+            single.primitive = c->name;
+            single.summary.median = static_cast<double>(result.elapsed_ns);
+            single.contention = result.contention;
+            single.perf = result.perf;
+            print_contention(std::cout, {single});
+            print_perf(std::cout, {single});
+        }
+        std::cout << '\n';
+    }
+}
+
+void run_bench_mode(const Options& opt) {
+    std::vector<BenchResult> results;
+    for (const PrimitiveCase* c : select_cases(opt.primitives)) {
+        std::cerr << "running " << c->name << "...\n";
+        results.push_back(run_benchmark(*c, opt.race, opt.bench));
+    }
+    attach_baseline(results, opt.race, opt.bench);
+    print_table(std::cout, results);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_csv(out, results); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_json(out, results, opt.bench); });
+    }
+}
+
+void run_sweep_mode(const Options& opt) {
+    const int max_threads = opt.max_threads > 0 ? opt.max_threads : default_max_threads();
+    std::vector<SweepCurve> curves;
+    for (const PrimitiveCase* c : select_cases(opt.primitives)) {
+        std::cerr << "sweeping " << c->name << " over 1.." << max_threads << " threads...\n";
+        curves.push_back(run_sweep(*c, opt.race, opt.bench, max_threads));
+    }
+    print_sweep(std::cout, curves);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_sweep_csv(out, curves); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_sweep_json(out, curves, opt.bench); });
+    }
+}
+
+void run_paths_mode(const Options& opt) {
+    const std::vector<PathCost> costs = measure_paths(select_cases(opt.primitives), opt.race, opt.bench);
+    print_paths(std::cout, costs);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_paths_csv(out, costs); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_paths_json(out, costs); });
+    }
+}
+
+void run_pingpong_mode(const Options& opt) {
+    std::vector<PingPongResult> results;
+    for (const PingPongCase* c : select_pingpong_cases(opt.primitives)) {
+        std::cerr << "ping-pong " << c->name << "...\n";
+        results.push_back(run_pingpong(*c, opt.pingpong));
+    }
+    print_pingpong(std::cout, results);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_pingpong_csv(out, results); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_pingpong_json(out, results); });
+    }
+}
+
+void run_timeouts_mode(const Options& opt) {
+    std::vector<TimeoutResult> results;
+    for (const TimeoutCase* c : select_timeout_cases(opt.primitives)) {
+        std::cerr << "timing out " << c->name << "...\n";
+        results.push_back(run_timeouts(*c, opt.timeouts));
+    }
+    print_timeouts(std::cout, results);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_timeouts_csv(out, results); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_timeouts_json(out, results); });
+    }
+}
+
+void run_layout_mode(const Options& opt) {
+    const std::string filter = opt.primitives.empty() ? layout_study_default : opt.primitives;
+    std::cerr << "benchmarking " << filter << " padded and packed...\n";
+    const std::vector<LayoutComparison> study = run_layout_study(select_cases(filter), opt.race, opt.bench);
+    print_layout_study(std::cout, study);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_layout_csv(out, study); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_layout_json(out, study); });
+    }
+}
+
+void run_stress_mode(const Options& opt) {
+    const std::string filter = opt.primitives.empty() ? stress_default : opt.primitives;
+    std::cerr << "stressing " << filter << " at " << opt.stress.oversubscription << "x oversubscription with "
+              << opt.stress.hogs << " CPU hogs...\n";
+    const std::vector<StressResult> results =
+        run_stress(select_cases(filter), opt.race, opt.bench, opt.stress);
+    print_stress(std::cout, results);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_stress_csv(out, results); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_stress_json(out, results); });
+    }
+}
+
+void run_orders_mode(const Options& opt) {
+    const std::string families = opt.primitives.empty() ? order_families : opt.primitives;
+    std::cerr << "torturing and benchmarking memory-order builds of " << families << "...\n";
+    const std::vector<OrderResult> study = run_order_study(families, opt.race, opt.bench);
+    print_order_study(std::cout, study);
+    if (!opt.csv_path.empty()) {
+        write_file(opt.csv_path, [&](std::ostream& out) { write_order_csv(out, study); });
+    }
+    if (!opt.json_path.empty()) {
+        write_file(opt.json_path, [&](std::ostream& out) { write_order_json(out, study); });
+    }
+    for (const auto& r : study) {
+        if (r.violations != 0) {
+            throw std::runtime_error(r.bench.primitive + " broke mutual exclusion in the torture run");
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    try {
+        opt = parse_options(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "error: " << e.what() << "\n\n";
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (opt.help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+
+    const ClockCalibration& clock = clock_calibration();
+    if (clock.tsc) {
+        std::cerr << "clock: invariant TSC via rdtscp, " << clock.ns_per_tick << " ns/tick, ";
+    } else {
+        std::cerr << "clock: clock_gettime(CLOCK_MONOTONIC), ";
+    }
+    std::cerr << clock.read_ns << " ns per reading\n";
+    std::cerr << "character generator: " << AsciiRng::kernel_name() << " kernel\n";
+
+    if (!opt.race.cpus.empty()) {
+        std::cerr << "pinning racers (" << opt.pin << "):";
+        for (int cpu : opt.race.cpus) {
+            std::cerr << ' ' << cpu;
+        }
+        std::cerr << '\n';
+    }
+
+    try {
+        switch (opt.mode) {
+        case Mode::race:
+            run_race_mode(opt);
+            break;
+        case Mode::bench:
+            run_bench_mode(opt);
+            break;
+        case Mode::sweep:
+            run_sweep_mode(opt);
+            break;
+        case Mode::paths:
+            run_paths_mode(opt);
+            break;
+        case Mode::pingpong:
+            run_pingpong_mode(opt);
+            break;
+        case Mode::layout:
+            run_layout_mode(opt);
+            break;
+        case Mode::stress:
+            run_stress_mode(opt);
+            break;
+        case Mode::orders:
+            run_orders_mode(opt);
+            break;
+        case Mode::timeouts:
+            run_timeouts_mode(opt);
+            break;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+    if (pin_failures() > 0) {
+        std::cerr << "warning: " << pin_failures()
+                  << " thread(s) could not be pinned and ran where the scheduler put them\n";
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "memory_orders.hpp"
+
+#include "cpu.hpp"
+#include "futex_sync.hpp"
+#include "primitives.hpp"
+#include "queue_locks.hpp"
+#include "topology.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <latch>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace lab4 {
+
+namespace {
+
+using Torture = std::uint64_t (*)(const RaceConfig&);
+
+int hardware_threads() {
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<int>(hw);
+}
+
+struct alignas(cache_line) Counter {
+    std::uint64_t value = 0;
+};
+
+template <LockPolicy Lock>
+std::uint64_t torture(const RaceConfig& cfg) {
+    Lock lock;
+    Counter first;
+    Counter second;
+    std::atomic<std::uint64_t> torn{0};
+    std::latch start(cfg.threads);
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<std::size_t>(cfg.threads));
+    for (int id = 0; id < cfg.threads; ++id) {
+        threads.emplace_back([&, id] {
+            pin_by_order(cfg.cpus, id);
+            std::uint64_t seen = 0;
+            start.arrive_and_wait();
+            for (std::size_t i = 0; i < cfg.chars; ++i) {
+                lock.lock();
+                seen += first.value != second.value ? 1 : 0;
+                ++first.value;
+                ++second.value;
+                lock.unlock();
+            }
+            torn.fetch_add(seen, std::memory_order_relaxed);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Lost increments count as well: two holders at once that never saw each other.
+    const std::uint64_t expected = total_chars(cfg);
+    const std::uint64_t lost = (expected - first.value) + (expected - second.value);
+    return torn.load(std::memory_order_relaxed) + lost;
+}
+
+struct Variant {
+    const char* family;
+    const char* suffix; // appended to the family for the registry name
+    const char* ordering;
+    Torture torture;
+};
+
+template <template <class> class Lock>
+std::vector<Variant> variants_of(const char* family) {
+    return {
+        {family, "-seqcst", SeqCstOrdering::name, torture<Lock<SeqCstOrdering>>},
+        {family, "", AcqRelOrdering::name, torture<Lock<AcqRelOrdering>>},
+        {family, "-fenced", FencedOrdering::name, torture<Lock<FencedOrdering>>},
+    };
+}
+
+std::vector<Variant> variants_of_family(const std::string& family) {
+    if (family == "spinlock") {
+        return variants_of<BasicSpinLock>("spinlock");
+    }
+    if (family == "ticket") {
+        return variants_of<BasicTicketLock>("ticket");
+    }
+    if (family == "mcs") {
+        return variants_of<BasicMcsLock>("mcs");
+    }
+    if (family == "clh") {
+        return variants_of<BasicClhLock>("clh");
+    }
+    if (family == "futex-mutex") {
+        return variants_of<BasicFutexMutex>("futex-mutex");
+    }
+    throw std::invalid_argument("no memory-order variants of " + family + " (have " + order_families + ")");
+}
+
+// The seq_cst build of r's family, which the other two are compared against.
+const OrderResult* seq_cst_of(const std::vector<OrderResult>& study, const OrderResult& r) {
+    for (const auto& other : study) {
+        if (other.family == r.family && other.ordering == SeqCstOrdering::name) {
+            return &other;
+        }
+    }
+    return nullptr;
+}
+
+double ratio(double value, double base) {
+    return base > 0 ? value / base : 0;
+}
+
+} // namespace
+
+std::vector<OrderResult> run_order_study(const std::string& families, const RaceConfig& race,
+                                         const BenchConfig& bench) {
+    detail::validate(race);
+    std::vector<Variant> variants;
+    std::istringstream names(families);
+    std::string family;
+    while (std::getline(names, family, ',')) {
+        if (!family.empty()) {
+            for (const Variant& v : variants_of_family(family)) {
+                variants.push_back(v);
+            }
+        }
+    }
+
+    RaceConfig fitted = race;
+    fitted.threads = std::min(race.threads, hardware_threads());
+
+    std::vector<OrderResult> study;
+    for (const Variant& v : variants) {
+        const PrimitiveCase& c = *select_cases(std::string(v.family) + v.suffix).front();
+        OrderResult result;
+        result.family = v.family;
+        result.ordering = v.ordering;
+        if (fitted.threads >= 2) {
+            result.torture_threads = fitted.threads;
+            result.violations = v.torture(fitted);
+        }
+        result.uncontended_ns = c.uncontended_ns ? c.uncontended_ns(1000000) : 0;
+        result.bench = run_benchmark(c, fitted, bench);
+        study.push_back(std::move(result));
+    }
+    return study;
+}
+
+void print_order_study(std::ostream& out, const std::vector<OrderResult>& study) {
+    const auto flags = out.flags();
+    out << std::left << std::setw(20) << "primitive" << std::setw(16) << "ordering" << std::right
+        << std::setw(10) << "torn" << std::setw(12) << "median ms" << std::setw(12) << "x seq_cst"
+        << std::setw(14) << "uncont. ns" << std::setw(12) << "x seq_cst" << '\n';
+    out << std::fixed;
+    for (const auto& r : study) {
+        const OrderResult* base = seq_cst_of(study, r);
+        out << std::left << std::setw(20) << r.bench.primitive << std::setw(16) << r.ordering << std::right
+            << std::setw(10);
+        if (r.torture_threads > 0) {
+            out << r.violations;
+        } else {
+            out << "skipped";
+        }
+        out << std::setprecision(3) << std::setw(12)
+            << r.bench.summary.median / 1e6 << std::setprecision(2) << std::setw(11)
+            << ratio(r.bench.summary.median, base ? base->bench.summary.median : 0) << 'x' << std::setw(14)
+            << r.uncontended_ns << std::setw(11) << ratio(r.uncontended_ns, base ? base->uncontended_ns : 0)
+            << "x\n";
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    out << "note: x86 is TSO, so torn = 0 does not show that a weakened ordering is correct\n";
+#endif
+    out.flags(flags);
+}
+
+void write_order_csv(std::ostream& out, const std::vector<OrderResult>& study) {
+    out << "primitive,family,ordering,threads,torture_threads,violations,median_ns,vs_seq_cst,uncontended_ns,"
+           "uncontended_vs_seq_cst\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    for (const auto& r : study) {
+        const OrderResult* base = seq_cst_of(study, r);
+        out << r.bench.primitive << ',' << r.family << ',' << r.ordering << ',' << r.bench.race.threads << ','
+            << r.torture_threads << ',' << r.violations << ',' << r.bench.summary.median << ','
+            << ratio(r.bench.summary.median, base ? base->bench.summary.median : 0) << ','
+            << r.uncontended_ns << ',' << ratio(r.uncontended_ns, base ? base->uncontended_ns : 0) << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_order_json(std::ostream& out, const std::vector<OrderResult>& study) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"orderings\": [";
+    for (std::size_t i = 0; i < study.size(); ++i) {
+        const OrderResult& r = study[i];
+        const OrderResult* base = seq_cst_of(study, r);
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(r.bench.primitive)
+            << "\", \"family\": \"" << json_escape(r.family) << "\", \"ordering\": \""
+            << json_escape(r.ordering) << "\", \"threads\": " << r.bench.race.threads
+            << ", \"torture_threads\": " << r.torture_threads << ", \"violations\": " << r.violations << ", \"median_ns\": " << r.bench.summary.median
+            << ", \"vs_seq_cst\": " << ratio(r.bench.summary.median, base ? base->bench.summary.median : 0)
+            << ", \"uncontended_ns\": " << r.uncontended_ns << ", \"uncontended_vs_seq_cst\": "
+            << ratio(r.uncontended_ns, base ? base->uncontended_ns : 0) << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+// Hand-written locks built in every OrderingPolicy, by their acq_rel name in
+// the registry; "<family>-seqcst" and "<family>-fenced" are the other two.
+// The other custom primitives have no variants of their own: cohort is two
+// ticket locks, spinwait and monitor take their exclusion from a FutexMutex,
+// so the ticket and futex-mutex variants already cover them; the barriers
+// publish phases rather than exclude, which this torture cannot check.
+inline constexpr const char* order_families = "spinlock,ticket,mcs,clh,futex-mutex";
+
+// One lock built with one ordering policy: first tortured, then benchmarked.
+struct OrderResult {
+    std::string family;
+    std::string ordering;
+    int torture_threads = 0;      // 0: skipped, fewer than two hardware threads
+    std::uint64_t violations = 0; // critical sections that saw another holder's half-done update
+    double uncontended_ns = 0;    // lock + unlock on one thread
+    BenchResult bench;
+};
+
+// Before the benchmark every variant goes through a mutual-exclusion torture:
+// each thread takes the lock race.chars times and bumps two counters on
+// separate cache lines, checking that they are equal first. The bare
+// counters are not atomic, so only the lock's ordering keeps them in step.
+// On x86 (TSO) the hardware never lets a load pass an older load or a store
+// pass an older store, so every variant compiles to an ordering that is
+// already sufficient there: a clean run only shows that the lock is atomic
+// and that the compiler kept the critical section inside it. A weakened
+// ordering can only be caught on a weakly ordered CPU such as ARM or POWER.
+// Torture and benchmark run at most one thread per hardware thread:
+// reordering needs parallel hardware to show, and an oversubscribed FIFO
+// spin lock pays a timeslice per handoff, which would drown the difference.
+std::vector<OrderResult> run_order_study(const std::string& families, const RaceConfig& race,
+                                         const BenchConfig& bench);
+
+// Median run time and uncontended pair cost relative to the seq_cst build.
+void print_order_study(std::ostream& out, const std::vector<OrderResult>& study);
+void write_order_csv(std::ostream& out, const std::vector<OrderResult>& study);
+void write_order_json(std::ostream& out, const std::vector<OrderResult>& study);
+
+} // namespace lab4
@@ -0,0 +1,117 @@
+#include "monitor.hpp"
+
+namespace lab4 {
+
+void Monitor::Queue::push(Node* node) noexcept {
+    node->next = nullptr;
+    if (tail == nullptr) {
+        head = node;
+    } else {
+        tail->next = node;
+    }
+    tail = node;
+}
+
+Monitor::Node* Monitor::Queue::pop() noexcept {
+    Node* node = head;
+    if (node != nullptr) {
+        head = node->next;
+        if (head == nullptr) {
+            tail = nullptr;
+        }
+    }
+    return node;
+}
+
+void Monitor::Queue::splice(Queue& other) noexcept {
+    if (other.head == nullptr) {
+        return;
+    }
+    if (tail == nullptr) {
+        head = other.head;
+    } else {
+        tail->next = other.head;
+    }
+    tail = other.tail;
+    other.head = other.tail = nullptr;
+}
+
+bool Monitor::Queue::remove(Node* node) noexcept {
+    Node* prev = nullptr;
+    for (Node* it = head; it != nullptr; prev = it, it = it->next) {
+        if (it == node) {
+            (prev == nullptr ? head : prev->next) = it->next;
+            if (tail == it) {
+                tail = prev;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void Monitor::wait() noexcept {
+    Node node;
+    waiting_.push(&node);
+    exit();
+    while (node.signaled.load(std::memory_order_acquire) == 0) {
+        futex_wait(node.signaled, 0);
+    }
+    enter();
+}
+
+bool Monitor::wait_slow(Deadline deadline, std::stop_token stop) noexcept {
+    Node node;
+    waiting_.push(&node);
+    exit();
+    {
+        auto cancel = [&node] {
+            node.signaled.fetch_or(cancelled, std::memory_order_relaxed);
+            futex_wake(node.signaled, 1);
+        };
+        std::stop_callback<decltype(cancel)> on_stop(stop, cancel);
+        while (node.signaled.load(std::memory_order_acquire) == 0) {
+            if (!futex_wait_until(node.signaled, 0, deadline)) {
+                break;
+            }
+        }
+    }
+    enter();
+    // A node still in the wait queue was never pulsed; one in the ready queue
+    // was, and we already own the monitor it was waiting for. A node in
+    // neither was popped by exit_and_wake(), which sets handed any moment now
+    // and must not find the node gone.
+    if (waiting_.remove(&node)) {
+        return false;
+    }
+    if (ready_.remove(&node)) {
+        return true;
+    }
+    std::uint32_t seen;
+    while (((seen = node.signaled.load(std::memory_order_acquire)) & handed) == 0) {
+        futex_wait(node.signaled, seen);
+    }
+    return true;
+}
+
+void Monitor::pulse() noexcept {
+    if (Node* node = waiting_.pop()) {
+        ready_.push(node);
+    }
+}
+
+void Monitor::pulse_all() noexcept {
+    ready_.splice(waiting_);
+}
+
+void Monitor::exit_and_wake() noexcept {
+    Node* node = ready_.pop();
+    lock_.unlock();
+    // The waiter may return as soon as it sees the flag, and the node lives on
+    // its stack: the wake below can hit a dead word, which at worst causes a
+    // spurious wake-up that every futex user here tolerates.
+    node->signaled.store(handed, std::memory_order_release);
+    futex_wake(node->signaled, 1);
+}
+
+} // namespace lab4
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "futex_sync.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stop_token>
+
+namespace lab4 {
+
+// C# System.Threading.Monitor: Enter/Exit plus Wait/Pulse/PulseAll.
+//
+// Every waiter parks on the futex word of its own queue node, so a wake-up is
+// always aimed at one thread. Pulse and PulseAll never wake anybody directly:
+// they move nodes from the wait queue to the ready queue, and each exit()
+// wakes one ready waiter after releasing the lock. A PulseAll thus turns into
+// a relay where every waiter finds the monitor free instead of a herd of
+// threads piling onto a lock the pulser still holds.
+//
+// Timed and cancellable waits sleep on the same node word with the deadline
+// in the futex. A waiter that gives up re-enters the monitor and unlinks its
+// own node, like Monitor.Wait(timeout) in C#.
+class Monitor {
+public:
+    Monitor() = default;
+    Monitor(const Monitor&) = delete;
+    Monitor& operator=(const Monitor&) = delete;
+
+    void enter() noexcept { lock_.lock(); }
+    bool try_enter() noexcept { return lock_.try_lock(); }
+
+    void exit() noexcept {
+        if (ready_.head == nullptr) {
+            lock_.unlock();
+        } else {
+            exit_and_wake();
+        }
+    }
+
+    // The calling thread must own the monitor, as in C#.
+    void wait() noexcept;
+    // Monitor.Wait(timeout): false when the deadline passed before a pulse.
+    // The monitor is owned again on return either way.
+    template <class Clock, class Duration>
+    bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return wait_slow(to_deadline(deadline), {});
+    }
+    template <class Rep, class Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+    // False when stop was requested before a pulse.
+    bool wait(std::stop_token stop) noexcept { return wait_slow(no_deadline, std::move(stop)); }
+    void pulse() noexcept;
+    void pulse_all() noexcept;
+
+    // Lockable, so the monitor can be used with std::lock_guard.
+    void lock() noexcept { enter(); }
+    bool try_lock() noexcept { return try_enter(); }
+    void unlock() noexcept { exit(); }
+
+private:
+    static constexpr std::uint32_t handed = 1;    // exit() gave the monitor up to this waiter
+    static constexpr std::uint32_t cancelled = 2; // the waiter's stop token fired
+
+    struct Node {
+        std::atomic<std::uint32_t> signaled{0};
+        Node* next = nullptr;
+    };
+
+    struct Queue {
+        Node* head = nullptr;
+        Node* tail = nullptr;
+
+        void push(Node* node) noexcept;
+        Node* pop() noexcept;
+        void splice(Queue& other) noexcept; // moves all of other to the back
+        bool remove(Node* node) noexcept;
+    };
+
+    bool wait_slow(Deadline deadline, std::stop_token stop) noexcept;
+    void exit_and_wake() noexcept;
+
+    FutexMutex lock_;
+    Queue waiting_; // guarded by lock_
+    Queue ready_;   // guarded by lock_
+};
+
+} // namespace lab4
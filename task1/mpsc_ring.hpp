@@ -0,0 +1,79 @@
+#pragma once
+
+#include "cpu.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+namespace lab4 {
+
+// Bounded lock-free multi-producer/single-consumer ring (Vyukov's bounded
+// queue with a CAS-free consumer). Every slot carries a sequence number that
+// tells producers whether it is free and the consumer whether it is filled,
+// so neither side ever waits on the other except when the ring is full or
+// empty.
+template <class T>
+class MpscRing {
+public:
+    explicit MpscRing(std::size_t capacity)
+        : mask_(capacity - 1), slots_(new Slot[capacity]) {
+        if (capacity < 2 || (capacity & mask_) != 0) {
+            throw std::invalid_argument("ring capacity must be a power of two");
+        }
+        for (std::size_t i = 0; i < capacity; ++i) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Any thread. Returns false when the ring is full.
+    bool try_push(const T& value) noexcept {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            const std::size_t seq = slot.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. Copies up to max ready elements to out and
+    // returns how many; stops at the first slot that is not filled yet.
+    std::size_t pop_bulk(T* out, std::size_t max) noexcept {
+        std::size_t n = 0;
+        while (n < max) {
+            Slot& slot = slots_[head_ & mask_];
+            if (slot.seq.load(std::memory_order_acquire) != head_ + 1) {
+                break;
+            }
+            out[n++] = slot.value;
+            slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+        }
+        return n;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(cache_line) std::atomic<std::size_t> tail_{0};
+    alignas(cache_line) std::size_t head_ = 0; // consumer only
+};
+
+} // namespace lab4
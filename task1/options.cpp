@@ -0,0 +1,197 @@
+#include "options.hpp"
+
+#include "topology.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+namespace lab4 {
+
+namespace {
+
+long long to_integer(const std::string& flag, const std::string& value, long long min) {
+    std::size_t used = 0;
+    long long parsed = 0;
+    try {
+        parsed = std::stoll(value, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != value.size() || value.empty()) {
+        throw std::invalid_argument(flag + " expects an integer, got '" + value + "'");
+    }
+    if (parsed < min) {
+        throw std::invalid_argument(flag + " must be at least " + std::to_string(min));
+    }
+    return parsed;
+}
+
+double to_real(const std::string& flag, const std::string& value) {
+    std::size_t used = 0;
+    double parsed = 0;
+    try {
+        parsed = std::stod(value, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != value.size() || value.empty()) {
+        throw std::invalid_argument(flag + " expects a number, got '" + value + "'");
+    }
+    return parsed;
+}
+
+} // namespace
+
+Options parse_options(int argc, char** argv) {
+    Options opt;
+    int i = 1;
+    if (i < argc && argv[i][0] != '-') {
+        const std::string mode = argv[i++];
+        if (mode == "race") {
+            opt.mode = Mode::race;
+        } else if (mode == "bench") {
+            opt.mode = Mode::bench;
+        } else if (mode == "sweep") {
+            opt.mode = Mode::sweep;
+        } else if (mode == "paths") {
+            opt.mode = Mode::paths;
+        } else if (mode == "pingpong") {
+            opt.mode = Mode::pingpong;
+        } else if (mode == "layout") {
+            opt.mode = Mode::layout;
+        } else if (mode == "stress") {
+            opt.mode = Mode::stress;
+        } else if (mode == "orders") {
+            opt.mode = Mode::orders;
+        } else if (mode == "timeouts") {
+            opt.mode = Mode::timeouts;
+        } else {
+            throw std::invalid_argument("unknown mode: " + mode);
+        }
+    }
+
+    for (; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(flag + " expects a value");
+            }
+            return argv[++i];
+        };
+
+        if (flag == "-h" || flag == "--help") {
+            opt.help = true;
+        } else if (flag == "--threads") {
+            opt.race.threads = static_cast<int>(to_integer(flag, value(), 1));
+        } else if (flag == "--chars") {
+            opt.race.chars = static_cast<std::size_t>(to_integer(flag, value(), 1));
+        } else if (flag == "--lap") {
+            opt.race.lap = static_cast<std::size_t>(to_integer(flag, value(), 1));
+        } else if (flag == "--seed") {
+            opt.race.seed = static_cast<unsigned>(to_integer(flag, value(), 0));
+        } else if (flag == "--workers") {
+            opt.race.workers = static_cast<unsigned>(to_integer(flag, value(), 1));
+        } else if (flag == "--sample-us") {
+            opt.race.sample_us = static_cast<std::uint64_t>(to_integer(flag, value(), 0));
+        } else if (flag == "--layout") {
+            opt.race.layout = parse_layout(value());
+        } else if (flag == "--echo") {
+            opt.race.echo = true;
+        } else if (flag == "--live") {
+            opt.race.live_fps = static_cast<unsigned>(to_integer(flag, value(), 1));
+        } else if (flag == "--contention") {
+            opt.race.contention = true;
+        } else if (flag == "--perf") {
+            opt.race.perf = true;
+        } else if (flag == "--pin") {
+            opt.pin = value();
+            opt.race.cpus = resolve_placement(opt.pin);
+            opt.pingpong.cpus = opt.race.cpus;
+            opt.timeouts.cpus = opt.race.cpus;
+        } else if (flag == "--warmup") {
+            opt.bench.warmup = static_cast<int>(to_integer(flag, value(), 0));
+        } else if (flag == "--iterations") {
+            opt.bench.iterations = static_cast<int>(to_integer(flag, value(), 1));
+        } else if (flag == "--outlier-k") {
+            opt.bench.outlier_k = to_real(flag, value());
+        } else if (flag == "--max-threads") {
+            opt.max_threads = static_cast<int>(to_integer(flag, value(), 1));
+        } else if (flag == "--rounds") {
+            opt.pingpong.rounds = static_cast<std::size_t>(to_integer(flag, value(), 1));
+        } else if (flag == "--timeout-us") {
+            opt.timeouts.timeout_us = to_integer(flag, value(), 1);
+        } else if (flag == "--waits") {
+            opt.timeouts.waits = static_cast<std::size_t>(to_integer(flag, value(), 1));
+        } else if (flag == "--oversub") {
+            opt.stress.oversubscription = static_cast<int>(to_integer(flag, value(), 1));
+        } else if (flag == "--hogs") {
+            opt.stress.hogs = static_cast<int>(to_integer(flag, value(), 0));
+        } else if (flag == "--primitives") {
+            opt.primitives = value();
+        } else if (flag == "--csv") {
+            opt.csv_path = value();
+        } else if (flag == "--json") {
+            opt.json_path = value();
+        } else {
+            throw std::invalid_argument("unknown option: " + flag);
+        }
+    }
+    return opt;
+}
+
+void print_usage(const char* program) {
+    std::printf(
+        "usage: %s [race|bench|sweep|paths|pingpong|layout|stress|orders|timeouts] [options]\n"
+        "\n"
+        "modes:\n"
+        "  race               run every primitive once and show the finishing order\n"
+        "  bench              repeated runs with statistics (default)\n"
+        "  sweep              bench every thread count from 1 to --max-threads\n"
+        "  paths              uncontended vs contended cost of every lock\n"
+        "  pingpong           two-thread handoff round trip through each primitive\n"
+        "  layout             false-sharing study: per-racer state padded vs packed\n"
+        "  stress             oversubscribed race with CPU hogs: spinning vs blocking\n"
+        "  orders             seq_cst vs acq_rel vs relaxed+fences builds of the spin/futex locks\n"
+        "  timeouts           deadline overshoot and stop_token latency of the timed waits\n"
+        "\n"
+        "race options:\n"
+        "  --threads N        number of racers (default 4)\n"
+        "  --chars N          characters emitted by each racer (default 10000)\n"
+        "  --lap N            characters between barrier phases (default 100)\n"
+        "  --seed N           random seed (default 1)\n"
+        "  --workers N        pool threads of the co-* races (default: hardware threads)\n"
+        "  --echo             print the track while racing\n"
+        "  --live FPS         draw a progress bar per racer FPS times a second\n"
+        "  --sample-us N      sample every racer's progress every N us (race mode prints it)\n"
+        "  --layout L         per-racer counters and slots: padded (default) or packed\n"
+        "  --contention       record wait/hold time histograms per primitive\n"
+        "  --perf             read perf_event counters (cycles, cache misses, ...)\n"
+        "  --pin PLACEMENT    none, compact (SMT siblings first), scatter (across\n"
+        "                     sockets and cores) or a CPU list such as 0,2,4-7\n"
+        "  --primitives LIST  comma separated subset, e.g. mutex,spinlock\n"
+        "\n"
+        "bench options:\n"
+        "  --warmup N         discarded runs per primitive (default 2)\n"
+        "  --iterations N     measured runs per primitive (default 15)\n"
+        "  --outlier-k X      Tukey fence multiplier, 0 disables rejection (default 1.5)\n"
+        "  --csv PATH         write the summary as CSV\n"
+        "  --json PATH        write the summary and raw samples as JSON\n"
+        "\n"
+        "sweep options:\n"
+        "  --max-threads N    last thread count (default 2x hardware threads)\n"
+        "\n"
+        "pingpong options:\n"
+        "  --rounds N         measured round trips per primitive (default 20000)\n"
+        "\n"
+        "stress options:\n"
+        "  --oversub N        racers per hardware thread in the stressed run (default 2)\n"
+        "  --hogs N           busy-looping background threads (default 0)\n"
+        "\n"
+        "timeouts options:\n"
+        "  --timeout-us N     deadline of each timed wait (default 200)\n"
+        "  --waits N          timed waits and cancellations per primitive (default 200)\n",
+        program);
+}
+
+} // namespace lab4
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "bench.hpp"
+#include "pingpong.hpp"
+#include "race.hpp"
+#include "stress.hpp"
+#include "timeouts.hpp"
+
+#include <string>
+
+namespace lab4 {
+
+enum class Mode { race, bench, sweep, paths, pingpong, layout, stress, orders, timeouts };
+
+struct Options {
+    Mode mode = Mode::bench;
+    RaceConfig race;
+    BenchConfig bench;
+    PingPongConfig pingpong;
+    StressConfig stress;
+    TimeoutConfig timeouts;
+    std::string primitives; // comma separated filter, empty = all
+    int max_threads = 0;    // sweep upper bound, 0 = default_max_threads()
+    std::string pin;        // none, compact, scatter or a CPU list
+    std::string csv_path;
+    std::string json_path;
+    bool help = false;
+};
+
+// Throws std::invalid_argument on a malformed command line.
+Options parse_options(int argc, char** argv);
+
+void print_usage(const char* program);
+
+} // namespace lab4
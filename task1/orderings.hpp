@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+
+namespace lab4 {
+
+// Memory-ordering policies for the hand-written primitives. A primitive asks
+// for the ordering each of its operations needs in the tuned version:
+// acquire, release or acq_rel on the synchronizing ones, plain on the rest.
+// It also brackets them with before_release() / after_acquire(). Only the
+// fenced policy turns those into real fences.
+template <class O>
+concept OrderingPolicy = requires {
+    { O::name } -> std::convertible_to<const char*>;
+    { O::plain } -> std::convertible_to<std::memory_order>;
+    { O::acquire } -> std::convertible_to<std::memory_order>;
+    { O::release } -> std::convertible_to<std::memory_order>;
+    { O::acq_rel } -> std::convertible_to<std::memory_order>;
+    O::before_release();
+    O::after_acquire();
+};
+
+// What naive code gets from the defaults: every access seq_cst, including
+// the ones that need no ordering at all.
+struct SeqCstOrdering {
+    static constexpr const char* name = "seq_cst";
+    static constexpr std::memory_order plain = std::memory_order_seq_cst;
+    static constexpr std::memory_order acquire = std::memory_order_seq_cst;
+    static constexpr std::memory_order release = std::memory_order_seq_cst;
+    static constexpr std::memory_order acq_rel = std::memory_order_seq_cst;
+    static void before_release() noexcept {}
+    static void after_acquire() noexcept {}
+};
+
+// The minimum each access needs: acquire on lock, release on unlock.
+struct AcqRelOrdering {
+    static constexpr const char* name = "acq_rel";
+    static constexpr std::memory_order plain = std::memory_order_relaxed;
+    static constexpr std::memory_order acquire = std::memory_order_acquire;
+    static constexpr std::memory_order release = std::memory_order_release;
+    static constexpr std::memory_order acq_rel = std::memory_order_acq_rel;
+    static void before_release() noexcept {}
+    static void after_acquire() noexcept {}
+};
+
+// Relaxed accesses with standalone fences. A spin loop polls with relaxed
+// loads and pays for one acquire fence after it succeeds instead of an
+// acquire load per iteration, which is where weakly ordered CPUs differ.
+struct FencedOrdering {
+    static constexpr const char* name = "relaxed+fences";
+    static constexpr std::memory_order plain = std::memory_order_relaxed;
+    static constexpr std::memory_order acquire = std::memory_order_relaxed;
+    static constexpr std::memory_order release = std::memory_order_relaxed;
+    static constexpr std::memory_order acq_rel = std::memory_order_relaxed;
+    static void before_release() noexcept { std::atomic_thread_fence(std::memory_order_release); }
+    static void after_acquire() noexcept { std::atomic_thread_fence(std::memory_order_acquire); }
+};
+
+} // namespace lab4
@@ -0,0 +1,55 @@
+#include "output.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <memory>
+
+#include <unistd.h>
+
+namespace lab4 {
+
+OutputSink::OutputSink(int fd) : fd_(fd), ring_(ring_capacity), writer_([this] { drain(); }) {}
+
+OutputSink::~OutputSink() {
+    close();
+}
+
+void OutputSink::close() {
+    if (writer_.joinable()) {
+        closing_.store(true, std::memory_order_release);
+        writer_.join();
+    }
+}
+
+void OutputSink::drain() {
+    std::unique_ptr<char[]> batch(new char[batch_size]);
+    for (;;) {
+        // Read the flag first: whatever was pushed before close() is then
+        // guaranteed to be seen by the pop that follows.
+        const bool closing = closing_.load(std::memory_order_acquire);
+        const std::size_t n = ring_.pop_bulk(batch.get(), batch_size);
+        if (n > 0) {
+            write_all(batch.get(), n);
+        } else if (closing) {
+            return;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+void OutputSink::write_all(const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd_, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // nothing sensible to do with a broken console
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+} // namespace lab4
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "mpsc_ring.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace lab4 {
+
+// Console output of the racers. They push characters into an MpscRing and
+// return at once; a single writer thread drains the ring and hands whole
+// batches to write(2), so nobody ever blocks on stdout while racing.
+class OutputSink {
+public:
+    static constexpr std::size_t ring_capacity = std::size_t{1} << 16;
+    static constexpr std::size_t batch_size = std::size_t{1} << 14;
+
+    explicit OutputSink(int fd);
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    ~OutputSink();
+
+    // Yields while the ring is full: the writer is the bottleneck then.
+    void put(char c) noexcept {
+        while (!ring_.try_push(c)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Writes out everything pushed so far and stops the writer thread.
+    void close();
+
+private:
+    void drain();
+    void write_all(const char* data, std::size_t size);
+
+    int fd_;
+    MpscRing<char> ring_;
+    std::atomic<bool> closing_{false};
+    std::thread writer_;
+};
+
+} // namespace lab4
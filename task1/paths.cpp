@@ -0,0 +1,78 @@
+#include "paths.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+
+namespace lab4 {
+
+std::vector<PathCost> measure_paths(const std::vector<const PrimitiveCase*>& cases,
+                                    const RaceConfig& race, const BenchConfig& bench) {
+    const std::size_t pairs = std::max<std::size_t>(total_chars(race), 1000);
+    std::vector<PathCost> costs;
+    for (const PrimitiveCase* c : cases) {
+        if (!c->uncontended_ns) {
+            continue;
+        }
+        std::cerr << "measuring " << c->name << "...\n";
+        for (int i = 0; i < bench.warmup; ++i) {
+            c->uncontended_ns(pairs);
+        }
+        std::vector<double> fast;
+        for (int i = 0; i < bench.iterations; ++i) {
+            fast.push_back(c->uncontended_ns(pairs));
+        }
+        std::sort(fast.begin(), fast.end());
+
+        const BenchResult contended = run_benchmark(*c, race, bench);
+        PathCost cost;
+        cost.primitive = c->name;
+        cost.threads = race.threads;
+        cost.uncontended_ns = percentile(fast, 0.5);
+        cost.contended_ns = contended.summary.median / static_cast<double>(total_chars(race));
+        costs.push_back(cost);
+    }
+    return costs;
+}
+
+void print_paths(std::ostream& out, const std::vector<PathCost>& costs) {
+    const auto flags = out.flags();
+    out << std::left << std::setw(20) << "primitive" << std::right << std::setw(16)
+        << "uncontended ns" << std::setw(16) << "contended ns" << std::setw(9) << "threads"
+        << '\n';
+    out << std::fixed << std::setprecision(2);
+    for (const auto& c : costs) {
+        out << std::left << std::setw(20) << c.primitive << std::right << std::setw(16)
+            << c.uncontended_ns << std::setw(16) << c.contended_ns << std::setw(9) << c.threads
+            << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_paths_csv(std::ostream& out, const std::vector<PathCost>& costs) {
+    out << "primitive,threads,uncontended_ns,contended_ns\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    for (const auto& c : costs) {
+        out << c.primitive << ',' << c.threads << ',' << c.uncontended_ns << ',' << c.contended_ns
+            << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_paths_json(std::ostream& out, const std::vector<PathCost>& costs) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"paths\": [";
+    for (std::size_t i = 0; i < costs.size(); ++i) {
+        const PathCost& c = costs[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(c.primitive)
+            << "\", \"threads\": " << c.threads << ", \"uncontended_ns\": " << c.uncontended_ns
+            << ", \"contended_ns\": " << c.contended_ns << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+// Cost of a lock's two paths: the uncontended fast path measured on one
+// thread, and the contended path as race time per character.
+struct PathCost {
+    std::string primitive;
+    int threads = 0;
+    double uncontended_ns = 0; // median over the bench iterations
+    double contended_ns = 0;   // median race time / characters
+};
+
+// Only lock primitives have an uncontended path; other cases are skipped.
+std::vector<PathCost> measure_paths(const std::vector<const PrimitiveCase*>& cases,
+                                    const RaceConfig& race, const BenchConfig& bench);
+
+void print_paths(std::ostream& out, const std::vector<PathCost>& costs);
+void write_paths_csv(std::ostream& out, const std::vector<PathCost>& costs);
+void write_paths_json(std::ostream& out, const std::vector<PathCost>& costs);
+
+} // namespace lab4
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab4 {
+
+enum class PerfEvent {
+    cycles,
+    instructions,
+    cache_misses,
+    llc_misses,
+    context_switches,
+    cpu_migrations,
+    hitm, // loads served by a modified line in another core's cache (Intel only)
+};
+
+inline constexpr std::size_t perf_event_count = 7;
+
+const char* perf_event_name(PerfEvent event);
+
+// Counter values of one measurement; events the kernel refused (no PMU in a
+// VM, perf_event_paranoid) stay invalid and are reported as n/a.
+struct PerfSample {
+    std::array<double, perf_event_count> values{};
+    std::array<bool, perf_event_count> valid{};
+
+    bool has(PerfEvent event) const { return valid[static_cast<std::size_t>(event)]; }
+    double get(PerfEvent event) const { return values[static_cast<std::size_t>(event)]; }
+    bool any() const;
+
+    // Sum of two samples; an event stays valid only if it is valid in both.
+    void add(const PerfSample& other);
+    void scale(double factor);
+};
+
+// perf_event_open counters for the calling thread and every thread it starts
+// afterwards (inherit), so they must be created before the racers are.
+// Counting is restricted to user space when the kernel does not allow more.
+class PerfCounters {
+public:
+    PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+    void start();
+    PerfSample stop();
+
+private:
+    std::array<int, perf_event_count> fds_;
+};
+
+} // namespace lab4
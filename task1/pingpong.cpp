@@ -0,0 +1,279 @@
+#include "pingpong.hpp"
+
+#include "barriers.hpp"
+#include "contention.hpp"
+#include "futex_sync.hpp"
+#include "monitor.hpp"
+#include "policies.hpp"
+#include "primitives.hpp"
+#include "pthread_sync.hpp"
+#include "spin_wait.hpp"
+#include "topology.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <semaphore>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace lab4 {
+
+namespace {
+
+// Runs ping on the calling side and pong on a second thread, collecting the
+// round trip of every measured ping.
+template <class Ping, class Pong>
+std::vector<std::int64_t> play(const PingPongConfig& cfg, Ping ping, Pong pong) {
+    const std::size_t total = cfg.warmup + cfg.rounds;
+    const double ns_per_tick = cycle_clock_ns_per_tick();
+    std::vector<std::int64_t> trips;
+    trips.reserve(cfg.rounds);
+
+    std::thread partner([&] {
+        pin_by_order(cfg.cpus, 1);
+        for (std::size_t i = 0; i < total; ++i) {
+            pong();
+        }
+    });
+    std::thread pinger([&] {
+        pin_by_order(cfg.cpus, 0);
+        for (std::size_t i = 0; i < total; ++i) {
+            const std::uint64_t start = cycle_clock();
+            ping();
+            const std::uint64_t back = cycle_clock();
+            if (i >= cfg.warmup) {
+                trips.push_back(static_cast<std::int64_t>(ticks_to_ns(back - start, ns_per_tick)));
+            }
+        }
+    });
+    pinger.join();
+    partner.join();
+    return trips;
+}
+
+// Two semaphores with no permits: each side releases the other's and
+// acquires its own.
+template <class Semaphore>
+std::vector<std::int64_t> semaphore_pingpong(const PingPongConfig& cfg) {
+    Semaphore to_pong(0);
+    Semaphore to_ping(0);
+    return play(
+        cfg,
+        [&] {
+            to_pong.release();
+            to_ping.acquire();
+        },
+        [&] {
+            to_pong.acquire();
+            to_ping.release();
+        });
+}
+
+// A turn flag guarded by the lock, with a condition_variable_any over that
+// same lock so the side whose turn it is not sleeps instead of polling; a
+// bare mutex has no way to hand itself to a particular thread.
+template <LockPolicy Lock>
+std::vector<std::int64_t> lock_pingpong(const PingPongConfig& cfg) {
+    Lock lock;
+    std::condition_variable_any turned;
+    int turn = 0;
+    auto pass = [&](int mine, int next, bool wait_back) {
+        std::unique_lock<Lock> guard(lock);
+        turned.wait(guard, [&] { return turn == mine; });
+        turn = next;
+        turned.notify_one();
+        if (wait_back) {
+            turned.wait(guard, [&] { return turn == mine; });
+        }
+    };
+    return play(
+        cfg, [&] { pass(0, 1, true); }, [&] { pass(1, 0, false); });
+}
+
+// Monitor.Wait/Pulse: the classic C# ping-pong.
+template <MonitorPolicy Monitor>
+std::vector<std::int64_t> monitor_pingpong(const PingPongConfig& cfg) {
+    Monitor monitor;
+    int turn = 0;
+    auto pass = [&](int mine, int next, bool wait_back) {
+        std::lock_guard<Monitor> guard(monitor);
+        while (turn != mine) {
+            monitor.wait();
+        }
+        turn = next;
+        monitor.pulse();
+        while (wait_back && turn != mine) {
+            monitor.wait();
+        }
+    };
+    return play(
+        cfg, [&] { pass(0, 1, true); }, [&] { pass(1, 0, false); });
+}
+
+// Turn word waited on with SpinWait: backoff spins, yields, then a futex
+// park announced through a sleeper count so the other side only pays for the
+// wake syscall when somebody sleeps.
+std::vector<std::int64_t> spinwait_pingpong(const PingPongConfig& cfg) {
+    std::atomic<std::uint32_t> turn{0};
+    std::atomic<std::uint32_t> sleepers{0};
+    auto wait_for = [&](std::uint32_t mine) {
+        SpinWait wait(SpinWaitLock<>::max_spin_cycles);
+        while (turn.load(std::memory_order_acquire) != mine) {
+            if (!wait.spin_once()) {
+                sleepers.fetch_add(1, std::memory_order_seq_cst);
+                const std::uint32_t seen = turn.load(std::memory_order_seq_cst);
+                if (seen != mine) {
+                    futex_wait(turn, seen);
+                }
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    };
+    auto pass = [&](std::uint32_t next) {
+        turn.store(next, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            futex_wake(turn, 1);
+        }
+    };
+    return play(
+        cfg,
+        [&] {
+            pass(1);
+            wait_for(0);
+        },
+        [&] {
+            wait_for(1);
+            pass(0);
+        });
+}
+
+// Two barrier phases per round trip: one handoff in each direction.
+template <BarrierPolicy Barrier>
+std::vector<std::int64_t> barrier_pingpong(const PingPongConfig& cfg) {
+    Barrier barrier(2);
+    auto phase = [&barrier](int id) {
+        return [&barrier, id] {
+            barrier.arrive_and_wait(id);
+            barrier.arrive_and_wait(id);
+        };
+    };
+    return play(cfg, phase(0), phase(1));
+}
+
+} // namespace
+
+const std::vector<PingPongCase>& pingpong_cases() {
+    static const std::vector<PingPongCase> cases = {
+        {"mutex", "turn flag under std::mutex, condition_variable_any", lock_pingpong<std::mutex>},
+        {"futex-mutex", "turn flag under FutexMutex, condition_variable_any", lock_pingpong<FutexMutex>},
+        {"pthread-mutex", "turn flag under pthread_mutex_t, condition_variable_any", lock_pingpong<PthreadMutex<>>},
+        {"semaphore", "pair of std::counting_semaphore", semaphore_pingpong<std::counting_semaphore<>>},
+        {"posix-semaphore", "pair of sem_t", semaphore_pingpong<PosixSemaphore>},
+        {"futex-semaphore", "pair of FutexSemaphore", semaphore_pingpong<FutexSemaphore>},
+        {"monitor", "Monitor.Wait/Pulse, per-waiter futex", monitor_pingpong<Monitor>},
+        {"monitor-cv", "Monitor.Wait/Pulse, condition_variable", monitor_pingpong<CondVarMonitor>},
+        {"spinwait", "turn word, SpinWait then futex park", spinwait_pingpong},
+        {"barrier", "std::barrier, two phases", barrier_pingpong<StdBarrier>},
+        {"sense-barrier", "sense-reversing barrier, two phases", barrier_pingpong<SenseBarrier>},
+        {"dissemination", "dissemination barrier, two phases", barrier_pingpong<DisseminationBarrier>},
+        {"tournament", "tournament barrier, two phases", barrier_pingpong<TournamentBarrier>},
+    };
+    return cases;
+}
+
+std::vector<const PingPongCase*> select_pingpong_cases(const std::string& filter) {
+    const auto& cases = pingpong_cases();
+    std::vector<const PingPongCase*> selected;
+    if (filter.empty()) {
+        for (const auto& c : cases) {
+            selected.push_back(&c);
+        }
+        return selected;
+    }
+
+    std::istringstream names(filter);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        if (name.empty()) {
+            continue;
+        }
+        const PingPongCase* found = nullptr;
+        for (const auto& c : cases) {
+            if (c.name == name) {
+                found = &c;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            throw std::invalid_argument("no ping-pong for primitive: " + name);
+        }
+        selected.push_back(found);
+    }
+    return selected;
+}
+
+PingPongResult run_pingpong(const PingPongCase& c, const PingPongConfig& cfg) {
+    if (cfg.rounds == 0) {
+        throw std::invalid_argument("ping-pong needs at least one round");
+    }
+    const std::vector<std::int64_t> trips = c.run(cfg);
+    std::vector<double> sorted(trips.begin(), trips.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    PingPongResult r;
+    r.primitive = c.name;
+    r.rounds = sorted.size();
+    r.p50 = percentile(sorted, 0.5);
+    r.p90 = percentile(sorted, 0.9);
+    r.p99 = percentile(sorted, 0.99);
+    r.p999 = percentile(sorted, 0.999);
+    r.max = sorted.back();
+    return r;
+}
+
+void print_pingpong(std::ostream& out, const std::vector<PingPongResult>& results) {
+    const auto flags = out.flags();
+    out << "round trip latency (ns):\n"
+        << std::left << std::setw(18) << "primitive" << std::right << std::setw(9) << "rounds"
+        << std::setw(11) << "p50" << std::setw(11) << "p90" << std::setw(11) << "p99"
+        << std::setw(11) << "p99.9" << std::setw(12) << "max" << '\n';
+    out << std::fixed << std::setprecision(0);
+    for (const auto& r : results) {
+        out << std::left << std::setw(18) << r.primitive << std::right << std::setw(9) << r.rounds
+            << std::setw(11) << r.p50 << std::setw(11) << r.p90 << std::setw(11) << r.p99
+            << std::setw(11) << r.p999 << std::setw(12) << r.max << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_pingpong_csv(std::ostream& out, const std::vector<PingPongResult>& results) {
+    out << "primitive,rounds,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        out << r.primitive << ',' << r.rounds << ',' << r.p50 << ',' << r.p90 << ',' << r.p99 << ','
+            << r.p999 << ',' << r.max << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_pingpong_json(std::ostream& out, const std::vector<PingPongResult>& results) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"pingpong\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const PingPongResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(r.primitive)
+            << "\", \"rounds\": " << r.rounds << ", \"p50_ns\": " << r.p50 << ", \"p90_ns\": " << r.p90
+            << ", \"p99_ns\": " << r.p99 << ", \"p999_ns\": " << r.p999 << ", \"max_ns\": " << r.max
+            << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
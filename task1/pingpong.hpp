@@ -0,0 +1,50 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+struct PingPongConfig {
+    std::size_t rounds = 20000; // measured round trips
+    std::size_t warmup = 1000;  // round trips thrown away first
+    std::vector<int> cpus;      // pinning of the two threads, as in RaceConfig
+};
+
+// Two threads hand control back and forth through one primitive; a round
+// trip is the time from the pinging thread giving control away until it
+// has it back.
+struct PingPongCase {
+    std::string name;
+    std::string description;
+    std::function<std::vector<std::int64_t>(const PingPongConfig&)> run; // round trips in ns
+};
+
+struct PingPongResult {
+    std::string primitive;
+    std::size_t rounds = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+};
+
+const std::vector<PingPongCase>& pingpong_cases();
+
+// Same filter syntax as select_cases().
+std::vector<const PingPongCase*> select_pingpong_cases(const std::string& filter);
+
+PingPongResult run_pingpong(const PingPongCase& c, const PingPongConfig& cfg);
+
+void print_pingpong(std::ostream& out, const std::vector<PingPongResult>& results);
+void write_pingpong_csv(std::ostream& out, const std::vector<PingPongResult>& results);
+void write_pingpong_json(std::ostream& out, const std::vector<PingPongResult>& results);
+
+} // namespace lab4
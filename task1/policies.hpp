@@ -0,0 +1,35 @@
+#pragma once
+
+#include <concepts>
+
+namespace lab4 {
+
+// What the race templates need from a primitive. Each primitive is passed
+// by its concrete type, so every race is its own instantiation and the lock
+// calls inline into the racer loop instead of going through a vtable.
+
+// Lockable in the std sense: guards the shared track with mutual exclusion.
+template <class L>
+concept LockPolicy = requires(L& lock) {
+    lock.lock();
+    { lock.try_lock() } -> std::convertible_to<bool>;
+    lock.unlock();
+};
+
+// Lock with C# Monitor condition semantics on top.
+template <class M>
+concept MonitorPolicy = LockPolicy<M> && requires(M& monitor) {
+    monitor.wait();
+    monitor.pulse();
+    monitor.pulse_all();
+};
+
+// Moves all racers from one lap to the next together. Built for a number of
+// threads; the racer id is passed because tree and dissemination barriers
+// need it.
+template <class B>
+concept BarrierPolicy = std::constructible_from<B, int> && requires(B& barrier, int id) {
+    barrier.arrive_and_wait(id);
+};
+
+} // namespace lab4
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "futex.hpp"
+#include "orderings.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <semaphore>
+#include <stop_token>
+#include <thread>
+
+namespace lab4 {
+
+// Plain test-and-set lock: every waiter hammers the same cache line.
+template <OrderingPolicy Order = AcqRelOrdering>
+class BasicSpinLock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(Order::acquire)) {
+        }
+        Order::after_acquire();
+    }
+    bool try_lock() noexcept {
+        if (flag_.test_and_set(Order::acquire)) {
+            return false;
+        }
+        Order::after_acquire();
+        return true;
+    }
+    // There is nothing to sleep on, so timed and cancellable waits spin and
+    // check the clock and the token between attempts.
+    template <class Clock, class Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return lock_until(to_deadline(deadline), {});
+    }
+    template <class Rep, class Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+    // False when stop was requested before the lock was acquired.
+    bool lock(std::stop_token stop) noexcept { return lock_until(no_deadline, stop); }
+    void unlock() noexcept {
+        Order::before_release();
+        flag_.clear(Order::release);
+    }
+
+private:
+    bool lock_until(Deadline deadline, const std::stop_token& stop) noexcept {
+        while (flag_.test_and_set(Order::acquire)) {
+            if (stop.stop_requested() || std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            cpu_relax();
+        }
+        Order::after_acquire();
+        return true;
+    }
+
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+using SpinLock = BasicSpinLock<>;
+
+// Semaphore with a single permit used as a lock (SemaphoreSlim(1, 1) in C#).
+template <class Semaphore = std::counting_semaphore<>>
+class SemaphoreLock {
+public:
+    void lock() { sem_.acquire(); }
+    bool try_lock() { return sem_.try_acquire(); }
+    void unlock() { sem_.release(); }
+
+private:
+    Semaphore sem_{1};
+};
+
+// C# Monitor on top of a mutex and a condition variable: the textbook version
+// the futex Monitor in monitor.hpp is compared against.
+class CondVarMonitor {
+public:
+    void enter() { mutex_.lock(); }
+    bool try_enter() { return mutex_.try_lock(); }
+    void exit() { mutex_.unlock(); }
+
+    // Must be called between enter() and exit().
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_, std::adopt_lock);
+        cv_.wait(lock);
+        lock.release();
+    }
+    // Monitor.Wait(timeout): false when the deadline passed before a pulse.
+    template <class Clock, class Duration>
+    bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline) {
+        std::unique_lock<std::mutex> lock(mutex_, std::adopt_lock);
+        const bool pulsed = cv_.wait_until(lock, deadline) == std::cv_status::no_timeout;
+        lock.release();
+        return pulsed;
+    }
+    template <class Rep, class Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+    // False when stop was requested before a pulse. The stop callback takes
+    // the mutex before notifying, so the request cannot slip in between the
+    // check and the wait; it is skipped when it runs inline because the stop
+    // came first, since this thread already holds the mutex then.
+    bool wait(std::stop_token stop) {
+        std::unique_lock<std::mutex> lock(mutex_, std::adopt_lock);
+        {
+            const std::thread::id waiter = std::this_thread::get_id();
+            std::stop_callback wake(stop, [this, waiter] {
+                if (std::this_thread::get_id() != waiter) {
+                    std::lock_guard<std::mutex> guard(mutex_);
+                    cv_.notify_all();
+                }
+            });
+            if (!stop.stop_requested()) {
+                cv_.wait(lock);
+            }
+            // A callback still running waits for the mutex; let it finish
+            // before the stop_callback destructor waits for it.
+            lock.unlock();
+        }
+        lock.lock();
+        lock.release();
+        return !stop.stop_requested();
+    }
+    void pulse() { cv_.notify_one(); }
+    void pulse_all() { cv_.notify_all(); }
+
+    // Lockable, so the monitor can be used with std::lock_guard.
+    void lock() { enter(); }
+    bool try_lock() { return try_enter(); }
+    void unlock() { exit(); }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+} // namespace lab4
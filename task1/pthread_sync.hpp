@@ -0,0 +1,98 @@
+#pragma once
+
+#include "futex.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <pthread.h>
+#include <semaphore.h>
+#include <system_error>
+
+namespace lab4 {
+
+// Deadline as the absolute CLOCK_MONOTONIC timespec glibc's clock*wait calls take.
+inline timespec monotonic_timespec(Deadline deadline) noexcept {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    return {static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+}
+
+// Raw pthread mutex, optionally of the glibc PTHREAD_MUTEX_ADAPTIVE_NP kind
+// that spins briefly before sleeping.
+template <bool Adaptive = false>
+class PthreadMutex {
+public:
+    PthreadMutex() {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+#ifdef PTHREAD_MUTEX_ADAPTIVE_NP
+        if constexpr (Adaptive) {
+            pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+        }
+#endif
+        const int rc = pthread_mutex_init(&mutex_, &attr);
+        pthread_mutexattr_destroy(&attr);
+        if (rc != 0) {
+            throw std::system_error(rc, std::generic_category(), "pthread_mutex_init");
+        }
+    }
+    PthreadMutex(const PthreadMutex&) = delete;
+    PthreadMutex& operator=(const PthreadMutex&) = delete;
+    ~PthreadMutex() { pthread_mutex_destroy(&mutex_); }
+
+    void lock() noexcept { pthread_mutex_lock(&mutex_); }
+    bool try_lock() noexcept { return pthread_mutex_trylock(&mutex_) == 0; }
+    void unlock() noexcept { pthread_mutex_unlock(&mutex_); }
+
+    // pthread_mutex_clocklock (glibc 2.30) sleeps in the futex until the deadline.
+    template <class Clock, class Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        const timespec at = monotonic_timespec(to_deadline(deadline));
+        return pthread_mutex_clocklock(&mutex_, CLOCK_MONOTONIC, &at) == 0;
+    }
+    template <class Rep, class Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
+// POSIX unnamed semaphore (sem_t) with the acquire/release interface of
+// std::counting_semaphore.
+class PosixSemaphore {
+public:
+    explicit PosixSemaphore(unsigned permits) {
+        if (sem_init(&sem_, 0, permits) != 0) {
+            throw std::system_error(errno, std::generic_category(), "sem_init");
+        }
+    }
+    PosixSemaphore(const PosixSemaphore&) = delete;
+    PosixSemaphore& operator=(const PosixSemaphore&) = delete;
+    ~PosixSemaphore() { sem_destroy(&sem_); }
+
+    void acquire() noexcept {
+        while (sem_wait(&sem_) != 0 && errno == EINTR) {
+        }
+    }
+    bool try_acquire() noexcept { return sem_trywait(&sem_) == 0; }
+    void release() noexcept { sem_post(&sem_); }
+
+    template <class Clock, class Duration>
+    bool try_acquire_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        const timespec at = monotonic_timespec(to_deadline(deadline));
+        int rc;
+        while ((rc = sem_clockwait(&sem_, CLOCK_MONOTONIC, &at)) != 0 && errno == EINTR) {
+        }
+        return rc == 0;
+    }
+    template <class Rep, class Period>
+    bool try_acquire_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_acquire_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+private:
+    sem_t sem_;
+};
+
+} // namespace lab4
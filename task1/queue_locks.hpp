@@ -0,0 +1,274 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "futex.hpp"
+#include "orderings.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+#include <vector>
+
+namespace lab4 {
+
+// Ticket lock: FIFO, but all waiters still poll the same now_serving word.
+template <OrderingPolicy Order = AcqRelOrdering>
+class BasicTicketLock {
+public:
+    void lock() noexcept {
+        const std::uint32_t ticket = next_.fetch_add(1, Order::plain);
+        while (serving_.load(Order::acquire) != ticket) {
+            cpu_relax();
+        }
+        Order::after_acquire();
+    }
+    bool try_lock() noexcept {
+        std::uint32_t serving = serving_.load(Order::plain);
+        if (!next_.compare_exchange_strong(serving, serving + 1, Order::acquire, Order::plain)) {
+            return false;
+        }
+        Order::after_acquire();
+        return true;
+    }
+    // A ticket cannot be handed back: everybody queued behind an abandoned
+    // one would wait forever. Timed and cancellable waits therefore never
+    // take a ticket and retry try_lock() until the deadline or the stop,
+    // which gives up FIFO order for them.
+    template <class Clock, class Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return lock_until(to_deadline(deadline), {});
+    }
+    template <class Rep, class Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+    // False when stop was requested before the lock was acquired.
+    bool lock(std::stop_token stop) noexcept { return lock_until(no_deadline, stop); }
+    void unlock() noexcept {
+        Order::before_release();
+        serving_.store(serving_.load(Order::plain) + 1, Order::release);
+    }
+    // Holder only: somebody has taken a ticket behind us.
+    bool has_waiters() const noexcept {
+        return next_.load(Order::plain) - serving_.load(Order::plain) > 1;
+    }
+
+private:
+    bool lock_until(Deadline deadline, const std::stop_token& stop) noexcept {
+        while (!try_lock()) {
+            if (stop.stop_requested() || std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            cpu_relax();
+        }
+        return true;
+    }
+
+    alignas(cache_line) std::atomic<std::uint32_t> next_{0};
+    alignas(cache_line) std::atomic<std::uint32_t> serving_{0};
+};
+
+using TicketLock = BasicTicketLock<>;
+
+// Mellor-Crummey/Scott lock: every waiter spins on a flag in its own node, and
+// the holder hands the lock directly to its successor.
+struct alignas(cache_line) McsNode {
+    std::atomic<McsNode*> next{nullptr};
+    std::atomic<bool> locked{false};
+};
+
+template <OrderingPolicy Order = AcqRelOrdering>
+class BasicMcsLock {
+public:
+    void lock(McsNode& node) noexcept {
+        node.next.store(nullptr, Order::plain);
+        node.locked.store(true, Order::plain);
+        Order::before_release();
+        McsNode* prev = tail_.exchange(&node, Order::acq_rel);
+        Order::after_acquire();
+        if (prev != nullptr) {
+            Order::before_release();
+            prev->next.store(&node, Order::release);
+            while (node.locked.load(Order::acquire)) {
+                cpu_relax();
+            }
+            Order::after_acquire();
+        }
+    }
+
+    void unlock(McsNode& node) noexcept {
+        McsNode* next = node.next.load(Order::acquire);
+        if (next == nullptr) {
+            McsNode* expected = &node;
+            Order::before_release();
+            if (tail_.compare_exchange_strong(expected, nullptr, Order::release, Order::plain)) {
+                return;
+            }
+            while ((next = node.next.load(Order::acquire)) == nullptr) {
+                cpu_relax();
+            }
+        }
+        Order::after_acquire();
+        Order::before_release();
+        next->locked.store(false, Order::release);
+    }
+
+    // BasicLockable form: the node comes from a small per-thread stack, so
+    // nested MCS locks have to be released in reverse order.
+    void lock() noexcept {
+        McsNode& node = node_stack().push();
+        lock(node);
+        owner_ = &node;
+    }
+    bool try_lock() noexcept {
+        McsNode& node = node_stack().push();
+        node.next.store(nullptr, Order::plain);
+        McsNode* expected = nullptr;
+        Order::before_release();
+        if (tail_.compare_exchange_strong(expected, &node, Order::acq_rel, Order::plain)) {
+            Order::after_acquire();
+            owner_ = &node;
+            return true;
+        }
+        node_stack().pop();
+        return false;
+    }
+    void unlock() noexcept {
+        unlock(*owner_);
+        node_stack().pop();
+    }
+
+private:
+    // Nesting deeper than depth spills to heap nodes rather than past the array.
+    struct NodeStack {
+        static constexpr int depth = 8;
+        McsNode nodes[depth];
+        std::vector<std::unique_ptr<McsNode>> spilled;
+        int top = 0;
+
+        McsNode& push() noexcept {
+            if (top < depth) {
+                return nodes[top++];
+            }
+            spilled.push_back(std::make_unique<McsNode>());
+            ++top;
+            return *spilled.back();
+        }
+        void pop() noexcept {
+            if (top > depth) {
+                spilled.pop_back();
+            }
+            --top;
+        }
+    };
+
+    static NodeStack& node_stack() noexcept {
+        thread_local NodeStack stack;
+        return stack;
+    }
+
+    alignas(cache_line) std::atomic<McsNode*> tail_{nullptr};
+    McsNode* owner_ = nullptr; // written by the holder only
+};
+
+using McsLock = BasicMcsLock<>;
+
+// Craig/Landin/Hagersten lock: an implicit queue where each waiter spins on
+// its predecessor's node and recycles that node once it gets the lock.
+template <OrderingPolicy Order = AcqRelOrdering>
+class BasicClhLock {
+public:
+    BasicClhLock() : tail_(new Node) {}
+    BasicClhLock(const BasicClhLock&) = delete;
+    BasicClhLock& operator=(const BasicClhLock&) = delete;
+    ~BasicClhLock() { delete tail_.load(std::memory_order_relaxed); }
+
+    void lock() {
+        Node* node = node_pool().take();
+        node->locked.store(true, Order::plain);
+        Order::before_release();
+        Node* pred = tail_.exchange(node, Order::acq_rel);
+        Order::after_acquire();
+        while (pred->locked.load(Order::acquire)) {
+            cpu_relax();
+        }
+        Order::after_acquire();
+        owner_ = node;
+        owner_pred_ = pred;
+    }
+
+    // Only enqueues when the tail is already released. If the tail node was
+    // recycled and re-enqueued in between (ABA), we are still a legal queue
+    // member and just wait for that predecessor like lock() does.
+    bool try_lock() {
+        Node* pred = tail_.load(Order::acquire);
+        Order::after_acquire();
+        if (pred->locked.load(Order::acquire)) {
+            return false;
+        }
+        Node* node = node_pool().take();
+        node->locked.store(true, Order::plain);
+        Order::before_release();
+        if (!tail_.compare_exchange_strong(pred, node, Order::acq_rel, Order::plain)) {
+            node_pool().give(node);
+            return false;
+        }
+        while (pred->locked.load(Order::acquire)) {
+            cpu_relax();
+        }
+        Order::after_acquire();
+        owner_ = node;
+        owner_pred_ = pred;
+        return true;
+    }
+
+    void unlock() {
+        Node* node = owner_;
+        Node* pred = owner_pred_;
+        Order::before_release();
+        node->locked.store(false, Order::release);
+        node_pool().give(pred); // nobody references the predecessor any more
+    }
+
+private:
+    struct alignas(cache_line) Node {
+        std::atomic<bool> locked{false};
+    };
+
+    // Nodes move between threads and locks; whatever a thread holds when it
+    // exits is freed here, the node left in the queue is freed by the lock.
+    struct NodePool {
+        std::vector<Node*> free;
+
+        Node* take() {
+            if (free.empty()) {
+                return new Node;
+            }
+            Node* node = free.back();
+            free.pop_back();
+            return node;
+        }
+        void give(Node* node) { free.push_back(node); }
+
+        ~NodePool() {
+            for (Node* node : free) {
+                delete node;
+            }
+        }
+    };
+
+    static NodePool& node_pool() {
+        thread_local NodePool pool;
+        return pool;
+    }
+
+    alignas(cache_line) std::atomic<Node*> tail_;
+    Node* owner_ = nullptr;      // written by the holder only
+    Node* owner_pred_ = nullptr;
+};
+
+using ClhLock = BasicClhLock<>;
+
+} // namespace lab4
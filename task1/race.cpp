@@ -0,0 +1,193 @@
+#include "race.hpp"
+
+#include "flat_combining.hpp"
+#include "futex.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace lab4 {
+
+std::size_t total_chars(const RaceConfig& cfg) {
+    return static_cast<std::size_t>(cfg.threads) * cfg.chars;
+}
+
+std::size_t lap_count(const RaceConfig& cfg) {
+    return (cfg.chars + cfg.lap - 1) / cfg.lap;
+}
+
+RaceResult run_free_race(const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+
+    RaceResult result;
+    detail::run_racers(cfg, board, result, [&](int id) {
+        AsciiRng rng(racer_seed(cfg.seed, id));
+        const std::size_t lane = static_cast<std::size_t>(id) * cfg.chars;
+        for (std::size_t i = 0; i < cfg.chars; ++i) {
+            const char c = rng.next();
+            board.track[lane + i] = c;
+            board.advance(id);
+            board.emit(c);
+        }
+        board.record_finish(id);
+    });
+
+    board.finish(result);
+    return result;
+}
+
+RaceResult run_combining_race(const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+
+    auto apply = [&board](char c, std::size_t) { board.track[board.cursor++] = c; };
+    FlatCombiner<char, decltype(apply)> combiner(static_cast<std::size_t>(cfg.threads), cfg.layout, apply);
+    std::vector<ContentionStats> per_racer(cfg.contention ? static_cast<std::size_t>(cfg.threads) : 0);
+    const double ns_per_tick = cfg.contention ? cycle_clock_ns_per_tick() : 0;
+
+    RaceResult result;
+    detail::run_racers(cfg, board, result, [&](int id) {
+        AsciiRng rng(racer_seed(cfg.seed, id));
+        const auto slot = static_cast<std::size_t>(id);
+        ContentionStats* stats = cfg.contention ? &per_racer[slot] : nullptr;
+        for (std::size_t i = 0; i < cfg.chars; ++i) {
+            const char c = rng.next();
+            if (stats != nullptr) {
+                const std::uint64_t start = cycle_clock();
+                const bool combined = combiner.execute(slot, c);
+                ++stats->acquisitions;
+                stats->contended += combined ? 0 : 1;
+                stats->wait_ns.record(ticks_to_ns(cycle_clock() - start, ns_per_tick));
+            } else {
+                combiner.execute(slot, c);
+            }
+            board.advance(id);
+            board.emit(c);
+        }
+        board.record_finish(id);
+    });
+
+    board.finish(result);
+    result.contention = detail::merge_all(per_racer);
+    return result;
+}
+
+namespace detail {
+
+RaceBoard::RaceBoard(const RaceConfig& cfg)
+    : track(total_chars(cfg), '\0'),
+      threads(static_cast<std::size_t>(cfg.threads)),
+      progress(threads, cfg.layout),
+      finish_order(threads, -1) {
+    if (cfg.echo) {
+        std::fflush(stdout);
+        output = std::make_unique<OutputSink>(STDOUT_FILENO);
+    }
+}
+
+std::vector<std::size_t> RaceBoard::sample_progress() const {
+    std::vector<std::size_t> sample(threads);
+    for (std::size_t id = 0; id < threads; ++id) {
+        sample[id] = progress[id].load(std::memory_order_relaxed);
+    }
+    return sample;
+}
+
+void RaceBoard::record_finish(int id) {
+    const int position = next_position.fetch_add(1, std::memory_order_relaxed);
+    if (position == 0) {
+        first_finish_progress = sample_progress();
+    }
+    finish_order[static_cast<std::size_t>(position)] = id;
+}
+
+void RaceBoard::finish(RaceResult& result) {
+    if (output) {
+        output->close();
+    }
+    result.finish_order = std::move(finish_order);
+    result.first_finish_progress = std::move(first_finish_progress);
+    result.track = std::move(track);
+}
+
+ProgressReporter::ProgressReporter(const RaceBoard& board, std::uint64_t period_us,
+                                   std::vector<ProgressSample>& samples)
+    : board_(board), samples_(samples) {
+    if (period_us == 0) {
+        return;
+    }
+    thread_ = std::thread([this, period_us] {
+        while (phase_.load(std::memory_order_acquire) == idle) {
+            futex_wait(phase_, idle);
+        }
+        watch_.restart();
+        while (phase_.load(std::memory_order_relaxed) == running) {
+            samples_.push_back({watch_.elapsed_ns(), board_.sample_progress()});
+            std::this_thread::sleep_for(std::chrono::microseconds(period_us));
+        }
+    });
+}
+
+void ProgressReporter::begin() noexcept {
+    if (!thread_.joinable()) {
+        return;
+    }
+    phase_.store(running, std::memory_order_release);
+    futex_wake(phase_, 1);
+}
+
+void ProgressReporter::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    const bool begun = phase_.exchange(stopping, std::memory_order_acq_rel) == running;
+    futex_wake(phase_, 1);
+    thread_.join();
+    if (begun) {
+        samples_.push_back({watch_.elapsed_ns(), board_.sample_progress()});
+    }
+}
+
+void validate(const RaceConfig& cfg) {
+    if (cfg.threads < 1) {
+        throw std::invalid_argument("race needs at least one thread");
+    }
+    if (cfg.lap == 0) {
+        throw std::invalid_argument("lap length must be positive");
+    }
+    if (cfg.echo && cfg.live_fps != 0) {
+        throw std::invalid_argument("--echo and --live both draw on stdout");
+    }
+}
+
+std::int64_t now_ns() {
+    return StopWatch::now_ns();
+}
+
+ContentionStats merge_all(const std::vector<ContentionStats>& per_racer) {
+    ContentionStats merged;
+    for (const auto& stats : per_racer) {
+        merged.merge(stats);
+    }
+    return merged;
+}
+
+std::vector<std::int64_t> phase_skews(const std::vector<std::int64_t>& arrivals, std::size_t threads) {
+    std::vector<std::int64_t> skews;
+    skews.reserve(arrivals.size() / threads);
+    for (auto first = arrivals.begin(); first != arrivals.end();
+         first += static_cast<std::ptrdiff_t>(threads)) {
+        const auto [lo, hi] = std::minmax_element(first, first + static_cast<std::ptrdiff_t>(threads));
+        skews.push_back(*hi - *lo);
+    }
+    return skews;
+}
+
+} // namespace detail
+
+} // namespace lab4
@@ -0,0 +1,364 @@
+#pragma once
+
+#include "ascii_rng.hpp"
+#include "contention.hpp"
+#include "layout.hpp"
+#include "live_view.hpp"
+#include "output.hpp"
+#include "perf_counters.hpp"
+#include "policies.hpp"
+#include "stopwatch.hpp"
+#include "topology.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lab4 {
+
+struct RaceConfig {
+    int threads = 4;
+    std::size_t chars = 10000; // characters emitted by every racer
+    std::size_t lap = 100;     // characters between two barrier phases
+    unsigned seed = 1;
+    bool echo = false;         // print the characters to stdout while racing
+    bool contention = false;   // record wait/hold histograms per racer
+    bool perf = false;         // read hardware/scheduler counters around the race
+    std::vector<int> cpus;     // racer i runs on cpus[i % size]; empty = unpinned
+    std::uint64_t sample_us = 0; // progress reporter period, 0 = no reporter thread
+    Layout layout = Layout::padded; // per-racer progress counters and combining slots
+    unsigned workers = 0;      // coroutine races: pool threads, 0 = one per hardware thread
+    unsigned live_fps = 0;     // frames per second of the live view, 0 = no renderer thread
+};
+
+// Progress of every racer as seen by the reporter thread at one moment.
+struct ProgressSample {
+    std::int64_t elapsed_ns = 0;
+    std::vector<std::size_t> progress;
+};
+
+struct RaceResult {
+    std::int64_t elapsed_ns = 0;
+    std::vector<int> finish_order;
+    // Characters per racer sampled by the first racer to finish, i.e. the
+    // acquisitions each one got while all of them were competing.
+    std::vector<std::size_t> first_finish_progress;
+    // Every cfg.sample_us while the race runs, plus one after the finish.
+    std::vector<ProgressSample> progress_samples;
+    std::string track;
+    // Phase race only: per lap, the time between the first and the last
+    // racer arriving at the barrier.
+    std::vector<std::int64_t> phase_skew_ns;
+    // Merged over all racers; empty unless cfg.contention is set.
+    ContentionStats contention;
+    // Counters over the timed part of the race; empty unless cfg.perf is set.
+    PerfSample perf;
+};
+
+std::size_t total_chars(const RaceConfig& cfg);
+
+// Barrier phases in a phase race: one per full or trailing partial lap.
+std::size_t lap_count(const RaceConfig& cfg);
+
+namespace detail {
+
+// Shared state of one race. Only the track and its cursor belong to the
+// primitive under test; progress and ranking are wait-free, so no lock is
+// taken for them in the racers' hot loop. Each racer's progress counter is
+// written by its owner only, with a relaxed load + store, and with the padded
+// layout sits on a line of its own so sampling it never drags a neighbour's
+// counter along.
+struct RaceBoard {
+    explicit RaceBoard(const RaceConfig& cfg);
+
+    // Characters go to the console outside the critical section.
+    void emit(char c) noexcept {
+        if (output) {
+            output->put(c);
+        }
+    }
+
+    // Called by racer id only.
+    void advance(int id) noexcept {
+        std::atomic<std::size_t>& value = progress[static_cast<std::size_t>(id)];
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Relaxed reads of every counter.
+    std::vector<std::size_t> sample_progress() const;
+
+    // A single fetch_add hands out the finishing position; the winner also
+    // samples everybody's progress.
+    void record_finish(int id);
+
+    // Called once the clock has stopped and the racers are done: closes the
+    // echo and moves the track and the ranking into the result.
+    void finish(RaceResult& result);
+
+    std::string track;
+    std::size_t cursor = 0;
+    std::size_t threads;
+    PerThread<std::atomic<std::size_t>> progress;
+    std::vector<int> finish_order; // one slot per position, each written once
+    std::vector<std::size_t> first_finish_progress;
+    alignas(cache_line) std::atomic<int> next_position{0};
+    std::unique_ptr<OutputSink> output;
+};
+
+// Thread that samples the board's progress counters every period_us from
+// begin() until it is stopped, then takes one last sample. It is created idle
+// before the race opens its perf counters, so they do not count it. Does
+// nothing when period_us is 0.
+class ProgressReporter {
+public:
+    ProgressReporter(const RaceBoard& board, std::uint64_t period_us, std::vector<ProgressSample>& samples);
+    ~ProgressReporter() { stop(); }
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    void begin() noexcept;
+    void stop();
+
+private:
+    static constexpr std::uint32_t idle = 0;
+    static constexpr std::uint32_t running = 1;
+    static constexpr std::uint32_t stopping = 2;
+
+    const RaceBoard& board_;
+    std::vector<ProgressSample>& samples_;
+    StopWatch watch_;
+    std::atomic<std::uint32_t> phase_{idle}; // futex word the idle thread waits on
+    std::thread thread_;
+};
+
+void validate(const RaceConfig& cfg);
+std::int64_t now_ns();
+ContentionStats merge_all(const std::vector<ContentionStats>& per_racer);
+// Spread between first and last arrival of every lap; arrivals is [lap][racer].
+std::vector<std::int64_t> phase_skews(const std::vector<std::int64_t>& arrivals, std::size_t threads);
+
+// Instrumented acquisition: a failed try_lock() marks it contended, and
+// everything until the racer may proceed (including waiting for its turn)
+// is wait time. Returns the moment the hold time starts.
+template <LockPolicy Lock, class WaitTurn>
+std::uint64_t timed_enter(Lock& lock, ContentionStats& stats, double ns_per_tick, WaitTurn wait_turn) {
+    const std::uint64_t start = cycle_clock();
+    bool contended = !lock.try_lock();
+    if (contended) {
+        lock.lock();
+    }
+    contended = wait_turn() || contended;
+    const std::uint64_t acquired = cycle_clock();
+    ++stats.acquisitions;
+    stats.contended += contended ? 1 : 0;
+    stats.wait_ns.record(ticks_to_ns(acquired - start, ns_per_tick));
+    return acquired;
+}
+
+template <LockPolicy Lock>
+void timed_leave(Lock& lock, ContentionStats& stats, double ns_per_tick, std::uint64_t acquired) {
+    stats.hold_ns.record(ticks_to_ns(cycle_clock() - acquired, ns_per_tick));
+    lock.unlock();
+}
+
+// Starts the racers, fires the start signal once all of them are ready and
+// measures the time until the last one crosses the finish line. The watch is
+// started before the signal, so a racer can never run ahead of the clock.
+template <class Body>
+void run_racers(const RaceConfig& cfg, const RaceBoard& board, RaceResult& result, Body body) {
+    const int threads = cfg.threads;
+    // Created before the counters, so the observers are not among the threads they count.
+    ProgressReporter reporter(board, cfg.sample_us, result.progress_samples);
+    LiveView view(board.progress, cfg.chars, cfg.live_fps);
+    std::optional<PerfCounters> counters; // opened before the racers so they inherit it
+    if (cfg.perf) {
+        counters.emplace();
+    }
+    std::latch ready(threads);
+    std::latch start(1);
+    std::vector<std::thread> racers;
+    racers.reserve(static_cast<std::size_t>(threads));
+    for (int id = 0; id < threads; ++id) {
+        racers.emplace_back([&cfg, &ready, &start, &body, id] {
+            pin_by_order(cfg.cpus, id);
+            ready.count_down();
+            start.wait();
+            body(id);
+        });
+    }
+    ready.wait();
+    if (counters) {
+        counters->start();
+    }
+    reporter.begin();
+    view.begin();
+    StopWatch watch;
+    start.count_down();
+    for (auto& racer : racers) {
+        racer.join();
+    }
+    result.elapsed_ns = watch.elapsed_ns();
+    view.stop();
+    reporter.stop();
+    if (counters) {
+        result.perf = counters->stop();
+    }
+}
+
+} // namespace detail
+
+// Zero-synchronization baseline: every racer fills its own lane with nothing
+// but the wait-free progress counters and ranking. What any primitive costs
+// on top of this is its overhead.
+RaceResult run_free_race(const RaceConfig& cfg);
+
+// Every racer emits cfg.chars random printable characters onto one shared
+// track, taking the lock around each character.
+template <LockPolicy Lock>
+RaceResult run_lock_race(Lock& lock, const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+
+    std::vector<ContentionStats> per_racer(cfg.contention ? static_cast<std::size_t>(cfg.threads) : 0);
+    const double ns_per_tick = cfg.contention ? cycle_clock_ns_per_tick() : 0;
+
+    RaceResult result;
+    detail::run_racers(cfg, board, result, [&](int id) {
+        AsciiRng rng(racer_seed(cfg.seed, id));
+        ContentionStats* stats = cfg.contention ? &per_racer[static_cast<std::size_t>(id)] : nullptr;
+        for (std::size_t i = 0; i < cfg.chars; ++i) {
+            const char c = rng.next();
+            std::uint64_t acquired = 0;
+            if (stats != nullptr) {
+                acquired = detail::timed_enter(lock, *stats, ns_per_tick, [] { return false; });
+            } else {
+                lock.lock();
+            }
+            board.track[board.cursor++] = c;
+            if (stats != nullptr) {
+                detail::timed_leave(lock, *stats, ns_per_tick, acquired);
+            } else {
+                lock.unlock();
+            }
+            board.advance(id);
+            board.emit(c);
+        }
+        board.record_finish(id);
+    });
+
+    board.finish(result);
+    result.contention = detail::merge_all(per_racer);
+    return result;
+}
+
+// Same track as run_lock_race, but the track and its cursor are only ever
+// updated through a FlatCombiner: a racer publishes its character and one
+// racer applies everybody's pending characters in a single hold. With
+// cfg.contention, wait is the time until the request is applied and
+// "contended" counts requests applied by another racer.
+RaceResult run_combining_race(const RaceConfig& cfg);
+
+// Racers put their characters on the shared track strictly in turns: each
+// one waits on the monitor until its turn comes, writes one character, passes
+// the turn on and wakes the others with PulseAll.
+template <MonitorPolicy Monitor>
+RaceResult run_turn_race(Monitor& monitor, const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+    int turn = 0; // guarded by the monitor
+    std::vector<ContentionStats> per_racer(cfg.contention ? static_cast<std::size_t>(cfg.threads) : 0);
+    const double ns_per_tick = cfg.contention ? cycle_clock_ns_per_tick() : 0;
+
+    RaceResult result;
+    detail::run_racers(cfg, board, result, [&](int id) {
+        AsciiRng rng(racer_seed(cfg.seed, id));
+        ContentionStats* stats = cfg.contention ? &per_racer[static_cast<std::size_t>(id)] : nullptr;
+        auto wait_turn = [&] {
+            bool waited = false;
+            while (turn != id) {
+                monitor.wait();
+                waited = true;
+            }
+            return waited;
+        };
+        for (std::size_t i = 0; i < cfg.chars; ++i) {
+            const char c = rng.next();
+            std::uint64_t acquired = 0;
+            if (stats != nullptr) {
+                acquired = detail::timed_enter(monitor, *stats, ns_per_tick, wait_turn);
+            } else {
+                monitor.lock();
+                wait_turn();
+            }
+            board.track[board.cursor++] = c;
+            turn = (turn + 1) % cfg.threads;
+            monitor.pulse_all();
+            if (stats != nullptr) {
+                detail::timed_leave(monitor, *stats, ns_per_tick, acquired);
+            } else {
+                monitor.unlock();
+            }
+            board.advance(id);
+            board.emit(c);
+        }
+        board.record_finish(id);
+    });
+
+    board.finish(result);
+    result.contention = detail::merge_all(per_racer);
+    return result;
+}
+
+// Every racer fills its own lane and meets the others at the barrier after
+// each lap of cfg.lap characters. Arrival times are recorded per lap.
+template <BarrierPolicy Barrier>
+RaceResult run_phase_race(Barrier& barrier, const RaceConfig& cfg) {
+    detail::validate(cfg);
+    detail::RaceBoard board(cfg);
+
+    const std::size_t laps = lap_count(cfg);
+    const auto threads = static_cast<std::size_t>(cfg.threads);
+    std::vector<std::int64_t> arrivals(laps * threads); // [lap][racer]
+    std::vector<ContentionStats> per_racer(cfg.contention ? threads : 0);
+    const double ns_per_tick = cfg.contention ? cycle_clock_ns_per_tick() : 0;
+
+    RaceResult result;
+    detail::run_racers(cfg, board, result, [&](int id) {
+        AsciiRng rng(racer_seed(cfg.seed, id));
+        ContentionStats* stats = cfg.contention ? &per_racer[static_cast<std::size_t>(id)] : nullptr;
+        const std::size_t lane = static_cast<std::size_t>(id) * cfg.chars;
+        std::size_t lap = 0;
+        for (std::size_t i = 0; i < cfg.chars; ++i) {
+            const char c = rng.next();
+            board.track[lane + i] = c;
+            board.advance(id);
+            board.emit(c);
+            if ((i + 1) % cfg.lap == 0 || i + 1 == cfg.chars) {
+                arrivals[lap++ * threads + static_cast<std::size_t>(id)] = detail::now_ns();
+                if (stats != nullptr) {
+                    const std::uint64_t arrived = cycle_clock();
+                    barrier.arrive_and_wait(id);
+                    ++stats->acquisitions;
+                    stats->wait_ns.record(ticks_to_ns(cycle_clock() - arrived, ns_per_tick));
+                } else {
+                    barrier.arrive_and_wait(id);
+                }
+            }
+        }
+        board.record_finish(id);
+    });
+
+    result.phase_skew_ns = detail::phase_skews(arrivals, threads);
+    board.finish(result);
+    result.contention = detail::merge_all(per_racer);
+    return result;
+}
+
+} // namespace lab4
@@ -0,0 +1,137 @@
+#include "registry.hpp"
+
+#include "barriers.hpp"
+#include "co_race.hpp"
+#include "cohort_lock.hpp"
+#include "futex_sync.hpp"
+#include "monitor.hpp"
+#include "primitives.hpp"
+#include "pthread_sync.hpp"
+#include "queue_locks.hpp"
+#include "spin_wait.hpp"
+#include "stopwatch.hpp"
+
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace lab4 {
+
+namespace {
+
+template <LockPolicy Lock>
+PrimitiveCase lock_case(std::string name, std::string description) {
+    return {std::move(name), std::move(description),
+            [](const RaceConfig& cfg) {
+                Lock lock;
+                return run_lock_race(lock, cfg);
+            },
+            [](std::size_t pairs) {
+                Lock lock;
+                StopWatch watch;
+                for (std::size_t i = 0; i < pairs; ++i) {
+                    lock.lock();
+                    lock.unlock();
+                }
+                return static_cast<double>(watch.elapsed_ns()) / static_cast<double>(pairs);
+            }};
+}
+
+template <MonitorPolicy Monitor>
+PrimitiveCase turn_case(std::string name, std::string description) {
+    return {std::move(name), std::move(description),
+            [](const RaceConfig& cfg) {
+                Monitor monitor;
+                return run_turn_race(monitor, cfg);
+            },
+            {}};
+}
+
+template <BarrierPolicy Barrier>
+PrimitiveCase phase_case(std::string name, std::string description) {
+    return {std::move(name), std::move(description),
+            [](const RaceConfig& cfg) {
+                Barrier barrier(cfg.threads);
+                return run_phase_race(barrier, cfg);
+            },
+            {}};
+}
+
+} // namespace
+
+const std::vector<PrimitiveCase>& primitive_cases() {
+    static const std::vector<PrimitiveCase> cases = {
+        {"none", "no synchronization: own lanes, wait-free progress and ranking", run_free_race, {}},
+        lock_case<std::mutex>("mutex", "std::mutex"),
+        lock_case<PthreadMutex<>>("pthread-mutex", "pthread_mutex_t, default kind"),
+        lock_case<PthreadMutex<true>>("pthread-adaptive", "pthread_mutex_t, PTHREAD_MUTEX_ADAPTIVE_NP"),
+        lock_case<FutexMutex>("futex-mutex", "futex mutex with atomic fast path"),
+        lock_case<BasicFutexMutex<SeqCstOrdering>>("futex-mutex-seqcst", "futex mutex, every access seq_cst"),
+        lock_case<BasicFutexMutex<FencedOrdering>>("futex-mutex-fenced", "futex mutex, relaxed accesses + fences"),
+        lock_case<SemaphoreLock<>>("semaphore", "std::counting_semaphore with one permit"),
+        lock_case<SemaphoreLock<PosixSemaphore>>("posix-semaphore", "sem_t with one permit"),
+        lock_case<SemaphoreLock<FutexSemaphore>>("futex-semaphore", "futex semaphore with one permit"),
+        phase_case<StdBarrier>("barrier", "std::barrier, one phase per lap"),
+        phase_case<SenseBarrier>("sense-barrier", "centralized sense-reversing barrier"),
+        phase_case<DisseminationBarrier>("dissemination", "dissemination barrier, log2(n) rounds"),
+        phase_case<TournamentBarrier>("tournament", "tournament barrier with tree wake-up"),
+        lock_case<SpinLock>("spinlock", "test-and-set spin lock"),
+        lock_case<BasicSpinLock<SeqCstOrdering>>("spinlock-seqcst", "test-and-set spin lock, every access seq_cst"),
+        lock_case<BasicSpinLock<FencedOrdering>>("spinlock-fenced", "test-and-set spin lock, relaxed accesses + fences"),
+        lock_case<TicketLock>("ticket", "ticket spin lock (FIFO, shared now-serving word)"),
+        lock_case<BasicTicketLock<SeqCstOrdering>>("ticket-seqcst", "ticket spin lock, every access seq_cst"),
+        lock_case<BasicTicketLock<FencedOrdering>>("ticket-fenced", "ticket spin lock, relaxed accesses + fences"),
+        lock_case<McsLock>("mcs", "MCS queue lock (spin on own node)"),
+        lock_case<BasicMcsLock<SeqCstOrdering>>("mcs-seqcst", "MCS queue lock, every access seq_cst"),
+        lock_case<BasicMcsLock<FencedOrdering>>("mcs-fenced", "MCS queue lock, relaxed accesses + fences"),
+        lock_case<ClhLock>("clh", "CLH queue lock (spin on predecessor's node)"),
+        lock_case<BasicClhLock<SeqCstOrdering>>("clh-seqcst", "CLH queue lock, every access seq_cst"),
+        lock_case<BasicClhLock<FencedOrdering>>("clh-fenced", "CLH queue lock, relaxed accesses + fences"),
+        lock_case<CohortLock>("cohort", "cohort lock: ticket lock per NUMA node + global ticket"),
+        lock_case<SpinWaitLock<>>("spinwait", "adaptive SpinWait: backoff spin, yield, futex park"),
+        lock_case<SpinWaitLock<WaitStrategy::spin>>("spinwait-spin", "SpinWait lock that only spins"),
+        lock_case<SpinWaitLock<WaitStrategy::park>>("spinwait-park", "SpinWait lock that parks at once"),
+        {"flat-combining", "one combiner applies every racer's pending update per hold", run_combining_race, {}},
+        lock_case<Monitor>("monitor", "Monitor.Enter/Exit, futex lock with per-waiter nodes"),
+        lock_case<CondVarMonitor>("monitor-cv", "Monitor.Enter/Exit on mutex + condition_variable"),
+        turn_case<Monitor>("monitor-turns", "turn-taking race, Wait/PulseAll, per-waiter futex"),
+        turn_case<CondVarMonitor>("monitor-cv-turns", "turn-taking race, Wait/PulseAll, condition_variable"),
+        {"co-mutex", "coroutine racers, CoMutex on a work-stealing pool", run_co_mutex_race, {}},
+        {"co-semaphore", "coroutine racers, CoSemaphore(1) on a work-stealing pool", run_co_semaphore_race, {}},
+        {"co-barrier", "coroutine racers, CoBarrier per lap on a work-stealing pool", run_co_barrier_race, {}},
+    };
+    return cases;
+}
+
+std::vector<const PrimitiveCase*> select_cases(const std::string& filter) {
+    const auto& cases = primitive_cases();
+    std::vector<const PrimitiveCase*> selected;
+    if (filter.empty()) {
+        for (const auto& c : cases) {
+            selected.push_back(&c);
+        }
+        return selected;
+    }
+
+    std::istringstream names(filter);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        if (name.empty()) {
+            continue;
+        }
+        const PrimitiveCase* found = nullptr;
+        for (const auto& c : cases) {
+            if (c.name == name) {
+                found = &c;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            throw std::invalid_argument("unknown primitive: " + name);
+        }
+        selected.push_back(found);
+    }
+    return selected;
+}
+
+} // namespace lab4
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "race.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+struct PrimitiveCase {
+    std::string name;
+    std::string description;
+    std::function<RaceResult(const RaceConfig&)> run;
+    // Average cost in ns of one lock + unlock pair on a single thread, i.e.
+    // the uncontended fast path. Empty for primitives that are not locks.
+    std::function<double(std::size_t pairs)> uncontended_ns;
+};
+
+// All primitives of Задание 1 in the order they are reported. The first one,
+// "none", is the zero-synchronization baseline.
+const std::vector<PrimitiveCase>& primitive_cases();
+
+// Cases listed in a comma separated filter, or every case when it is empty.
+// Throws std::invalid_argument on an unknown name.
+std::vector<const PrimitiveCase*> select_cases(const std::string& filter);
+
+} // namespace lab4
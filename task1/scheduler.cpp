@@ -0,0 +1,110 @@
+#include "scheduler.hpp"
+
+#include "futex.hpp"
+#include "spin_wait.hpp"
+#include "topology.hpp"
+
+#include <climits>
+#include <mutex>
+#include <stdexcept>
+
+namespace lab4 {
+
+namespace {
+
+thread_local const Scheduler* current_pool = nullptr;
+thread_local unsigned current_worker = 0;
+
+} // namespace
+
+Scheduler::Scheduler(unsigned workers, const std::vector<int>& cpus)
+    : queues_(new Queue[workers == 0 ? 1 : workers]), queue_count_(workers) {
+    if (workers == 0) {
+        throw std::invalid_argument("scheduler needs at least one worker");
+    }
+    threads_.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        threads_.emplace_back([this, i, cpus] { work(i, cpus); });
+    }
+}
+
+Scheduler::~Scheduler() {
+    stop_.store(true, std::memory_order_seq_cst);
+    wake_seq_.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(wake_seq_, INT_MAX);
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void Scheduler::schedule(std::coroutine_handle<> handle) {
+    const unsigned index = current_pool == this ? current_worker
+                                                : next_.fetch_add(1, std::memory_order_relaxed) % queue_count_;
+    {
+        Queue& queue = queues_[index];
+        std::lock_guard<FutexMutex> guard(queue.lock);
+        queue.items.push_back(handle);
+    }
+    // Pairs with the fence in work(): either the sleeper sees the new item on
+    // its last look, or we see it counted and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) > 0) {
+        wake_seq_.fetch_add(1, std::memory_order_release);
+        futex_wake(wake_seq_, 1);
+    }
+}
+
+std::coroutine_handle<> Scheduler::find_work(unsigned index) {
+    {
+        Queue& own = queues_[index];
+        std::lock_guard<FutexMutex> guard(own.lock);
+        if (!own.items.empty()) {
+            const auto handle = own.items.back();
+            own.items.pop_back();
+            return handle;
+        }
+    }
+    for (unsigned step = 1; step < queue_count_; ++step) {
+        Queue& victim = queues_[(index + step) % queue_count_];
+        std::lock_guard<FutexMutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            const auto handle = victim.items.front();
+            victim.items.pop_front();
+            return handle;
+        }
+    }
+    return nullptr;
+}
+
+void Scheduler::work(unsigned index, const std::vector<int>& cpus) {
+    current_pool = this;
+    current_worker = index;
+    pin_by_order(cpus, static_cast<int>(index));
+    for (;;) {
+        std::coroutine_handle<> handle = find_work(index);
+        SpinWait wait(SpinWaitLock<>::max_spin_cycles);
+        while (!handle && wait.spin_once()) {
+            handle = find_work(index);
+        }
+        if (handle) {
+            handle.resume();
+            continue;
+        }
+
+        const std::uint32_t seq = wake_seq_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        handle = find_work(index);
+        if (!handle && !stop_.load(std::memory_order_acquire)) {
+            futex_wait(wake_seq_, seq);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        if (handle) {
+            handle.resume();
+        } else if (stop_.load(std::memory_order_acquire)) {
+            return;
+        }
+    }
+}
+
+} // namespace lab4
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "futex_sync.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace lab4 {
+
+// Fire-and-forget coroutine: created suspended, started by handing its handle
+// to a Scheduler, destroys its own frame when the body returns.
+struct Detached {
+    struct promise_type {
+        // Frames hold over-aligned locals (AsciiRng's SIMD state), which the
+        // default frame allocation does not respect.
+        static void* operator new(std::size_t size) {
+            return ::operator new(size, std::align_val_t{cache_line});
+        }
+        static void operator delete(void* frame) noexcept {
+            ::operator delete(frame, std::align_val_t{cache_line});
+        }
+
+        Detached get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Work-stealing pool of worker threads running coroutine handles. Each worker
+// owns a deque: it pushes and pops at the back (the coroutine it just woke
+// runs next, while its data is still in cache), idle workers steal from the
+// front of the others. A worker with nothing to run or steal spins with
+// SpinWait, then sleeps on a futex eventcount.
+class Scheduler {
+public:
+    // Worker i is pinned to cpus[i % size] when cpus is not empty.
+    explicit Scheduler(unsigned workers, const std::vector<int>& cpus = {});
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Queues a suspended coroutine: on the calling worker's own deque, or
+    // round-robin over all deques when called from outside the pool.
+    void schedule(std::coroutine_handle<> handle);
+
+    unsigned workers() const noexcept { return static_cast<unsigned>(threads_.size()); }
+
+private:
+    struct alignas(cache_line) Queue {
+        FutexMutex lock;
+        std::deque<std::coroutine_handle<>> items;
+    };
+
+    void work(unsigned index, const std::vector<int>& cpus);
+    std::coroutine_handle<> find_work(unsigned index);
+
+    std::unique_ptr<Queue[]> queues_;
+    unsigned queue_count_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_{false};
+    std::atomic<unsigned> next_{0};
+    alignas(cache_line) std::atomic<std::uint32_t> wake_seq_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+};
+
+} // namespace lab4
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "futex_sync.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stop_token>
+#include <thread>
+
+namespace lab4 {
+
+// Counterpart of System.Threading.SpinWait, extended with a parking stage:
+// pause-instruction spins with exponential backoff while the spin budget
+// lasts, then a few yields; after that spin_once() returns false and the
+// caller is expected to park.
+class SpinWait {
+public:
+    static constexpr int max_backoff = 64; // pauses per spin at the end of the backoff
+    static constexpr int max_yields = 4;
+
+    explicit SpinWait(std::uint64_t budget_cycles) noexcept
+        : start_(cycle_clock()), budget_(budget_cycles) {}
+
+    bool spin_once() noexcept {
+        if (cycle_clock() - start_ < budget_) {
+            for (int i = 0; i < backoff_; ++i) {
+                cpu_relax();
+            }
+            backoff_ = std::min(backoff_ * 2, max_backoff);
+            return true;
+        }
+        if (yields_ < max_yields) {
+            ++yields_;
+            std::this_thread::yield();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    std::uint64_t start_;
+    std::uint64_t budget_;
+    int backoff_ = 1;
+    int yields_ = 0;
+};
+
+enum class WaitStrategy {
+    adaptive, // spin for about the expected hold time, yield, then park
+    spin,     // never leave the CPU
+    park,     // go to the futex straight away
+};
+
+// FutexMutex whose waiters go through SpinWait before parking. The adaptive
+// flavour sizes the spin budget from a moving average of the measured hold
+// times: when the lock is usually released sooner than a park/wake round
+// trip, spinning wins. Timed and cancellable acquisitions spin the same way
+// (the spin stage is bounded by max_spin_cycles) and then park with the
+// deadline in the futex; only the spin-only flavour has to poll the clock.
+template <WaitStrategy Strategy = WaitStrategy::adaptive>
+class SpinWaitLock {
+public:
+    static constexpr std::uint64_t max_spin_cycles = 20000; // about one futex sleep + wake
+
+    void lock() noexcept {
+        if (!mutex_.try_lock()) {
+            lock_slow();
+        }
+        if constexpr (Strategy == WaitStrategy::adaptive) {
+            acquired_at_ = cycle_clock();
+        }
+    }
+
+    bool try_lock() noexcept { return acquired(mutex_.try_lock()); }
+
+    template <class Clock, class Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        return acquired(mutex_.try_lock() || lock_slow(to_deadline(deadline), {}));
+    }
+
+    template <class Rep, class Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // False when stop was requested before the lock was acquired.
+    bool lock(std::stop_token stop) noexcept { return acquired(mutex_.try_lock() || lock_slow(no_deadline, stop)); }
+
+    void unlock() noexcept {
+        if constexpr (Strategy == WaitStrategy::adaptive) {
+            const std::uint64_t held = cycle_clock() - acquired_at_;
+            const std::uint64_t estimate = hold_estimate_.load(std::memory_order_relaxed);
+            hold_estimate_.store(estimate - estimate / 8 + held / 8, std::memory_order_relaxed);
+        }
+        mutex_.unlock();
+    }
+
+    // Current spin budget in cycle_clock() ticks.
+    std::uint64_t spin_budget() const noexcept {
+        if constexpr (Strategy == WaitStrategy::adaptive) {
+            return std::min(2 * hold_estimate_.load(std::memory_order_relaxed), max_spin_cycles);
+        } else {
+            return 0;
+        }
+    }
+
+private:
+    bool try_acquire_spinning() noexcept { return !mutex_.is_locked() && mutex_.try_lock(); }
+
+    void lock_slow() noexcept {
+        if constexpr (Strategy == WaitStrategy::spin) {
+            int backoff = 1;
+            while (!try_acquire_spinning()) {
+                for (int i = 0; i < backoff; ++i) {
+                    cpu_relax();
+                }
+                backoff = std::min(backoff * 2, SpinWait::max_backoff);
+            }
+            return;
+        } else if constexpr (Strategy == WaitStrategy::adaptive) {
+            SpinWait wait(spin_budget());
+            while (wait.spin_once()) {
+                if (try_acquire_spinning()) {
+                    return;
+                }
+            }
+        }
+        mutex_.lock_contended();
+    }
+
+    bool lock_slow(Deadline deadline, const std::stop_token& stop) noexcept {
+        if constexpr (Strategy == WaitStrategy::spin) {
+            int backoff = 1;
+            while (!try_acquire_spinning()) {
+                if (stop.stop_requested() || std::chrono::steady_clock::now() >= deadline) {
+                    return false;
+                }
+                for (int i = 0; i < backoff; ++i) {
+                    cpu_relax();
+                }
+                backoff = std::min(backoff * 2, SpinWait::max_backoff);
+            }
+            return true;
+        } else if constexpr (Strategy == WaitStrategy::adaptive) {
+            SpinWait wait(spin_budget());
+            while (wait.spin_once()) {
+                if (try_acquire_spinning()) {
+                    return true;
+                }
+            }
+        }
+        return mutex_.lock_contended(deadline, stop);
+    }
+
+    bool acquired(bool success) noexcept {
+        if constexpr (Strategy == WaitStrategy::adaptive) {
+            if (success) {
+                acquired_at_ = cycle_clock();
+            }
+        }
+        return success;
+    }
+
+    FutexMutex mutex_;
+    std::atomic<std::uint64_t> hold_estimate_{1000};
+    std::uint64_t acquired_at_ = 0; // written by the holder only
+};
+
+} // namespace lab4
@@ -0,0 +1,106 @@
+#include "stopwatch.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace lab4 {
+
+namespace {
+
+std::uint64_t monotonic_ns() noexcept {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// CPUID.80000007H:EDX[8]: the TSC ticks at a constant rate in every P-, C-
+// and T-state. rdtscp itself is CPUID.80000001H:EDX[27].
+bool has_invariant_tsc() noexcept {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u) {
+        return false;
+    }
+    __get_cpuid(0x80000001u, &eax, &ebx, &ecx, &edx);
+    if ((edx & (1u << 27)) == 0) {
+        return false;
+    }
+    __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+
+struct ClockPair {
+    std::uint64_t tsc;
+    std::uint64_t mono_ns;
+};
+
+// The tightest of a few rdtscp / clock_gettime / rdtscp brackets, so that a
+// preemption or an interrupt between the two reads does not skew the fit.
+ClockPair sample_pair() noexcept {
+    ClockPair best{0, 0};
+    std::uint64_t best_width = ~std::uint64_t{0};
+    for (int i = 0; i < 16; ++i) {
+        unsigned aux;
+        const std::uint64_t before = __rdtscp(&aux);
+        const std::uint64_t mono = monotonic_ns();
+        const std::uint64_t after = __rdtscp(&aux);
+        if (after - before < best_width) {
+            best_width = after - before;
+            best = {before + (after - before) / 2, mono};
+        }
+    }
+    return best;
+}
+
+#endif
+
+// Mean cost of one read; the calibration is still being built, so the raw
+// reads are timed instead of StopWatch::ticks().
+template <class Read>
+double time_reads(Read read) noexcept {
+    constexpr int reads = 1 << 14;
+    std::uint64_t sink = 0;
+    const std::uint64_t start = monotonic_ns();
+    for (int i = 0; i < reads; ++i) {
+        sink += read();
+    }
+    const std::uint64_t stop = monotonic_ns();
+    asm volatile("" : : "r"(sink));
+    return static_cast<double>(stop - start) / reads;
+}
+
+} // namespace
+
+ClockCalibration calibrate_clock() {
+    ClockCalibration calibration;
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_invariant_tsc()) {
+        // Busy-wait rather than sleep: 20 ms is long enough for a fit to a
+        // few ppm and short enough not to be noticed at startup.
+        const ClockPair first = sample_pair();
+        while (monotonic_ns() - first.mono_ns < 20000000u) {
+        }
+        const ClockPair last = sample_pair();
+        if (last.tsc > first.tsc) {
+            calibration.tsc = true;
+            calibration.ns_per_tick = static_cast<double>(last.mono_ns - first.mono_ns) /
+                                      static_cast<double>(last.tsc - first.tsc);
+        }
+    }
+#endif
+    if (calibration.tsc) {
+#if defined(__x86_64__) || defined(__i386__)
+        calibration.read_ns = time_reads([] {
+            unsigned aux;
+            return __rdtscp(&aux);
+        });
+#endif
+    } else {
+        calibration.read_ns = time_reads(monotonic_ns);
+    }
+    return calibration;
+}
+
+} // namespace lab4
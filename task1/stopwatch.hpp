@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace lab4 {
+
+// How StopWatch reads time on this machine, measured once per process.
+struct ClockCalibration {
+    bool tsc = false;         // invariant TSC read with rdtscp; otherwise clock_gettime
+    double ns_per_tick = 1.0; // TSC period against CLOCK_MONOTONIC; 1 for the fallback
+    double read_ns = 0;       // cost of one StopWatch reading
+};
+
+// Checks CPUID for an invariant TSC and, if there is one, fits its rate to
+// CLOCK_MONOTONIC over a few milliseconds. Prefer clock_calibration().
+ClockCalibration calibrate_clock();
+
+// Calibrated on first use; main() calls it at startup so the few
+// milliseconds it takes never land inside a measurement.
+inline const ClockCalibration& clock_calibration() {
+    static const ClockCalibration calibration = calibrate_clock();
+    return calibration;
+}
+
+// Equivalent of System.Diagnostics.Stopwatch used by the C# version of the
+// lab. A reading is one rdtscp (a few ns) when the TSC is invariant, so
+// timing sub-100 ns lock operations does not drown in clock overhead;
+// without one it falls back to clock_gettime(CLOCK_MONOTONIC).
+class StopWatch {
+public:
+    StopWatch() noexcept : start_(ticks()) {}
+
+    void restart() noexcept { start_ = ticks(); }
+
+    std::int64_t elapsed_ns() const noexcept { return to_ns(ticks() - start_); }
+
+    double elapsed_ms() const noexcept { return static_cast<double>(elapsed_ns()) / 1e6; }
+
+    // Raw reading: TSC cycles, or nanoseconds on the fallback path.
+    static std::uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        if (clock_calibration().tsc) {
+            unsigned aux;
+            return __rdtscp(&aux);
+        }
+#endif
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    static std::int64_t to_ns(std::uint64_t ticks) noexcept {
+        return static_cast<std::int64_t>(static_cast<double>(ticks) * clock_calibration().ns_per_tick);
+    }
+
+    // Timestamp comparable across threads (the invariant TSC is synchronized
+    // between cores); only differences are meaningful.
+    static std::int64_t now_ns() noexcept { return to_ns(ticks()); }
+
+private:
+    std::uint64_t start_;
+};
+
+} // namespace lab4
@@ -0,0 +1,156 @@
+#include "stress.hpp"
+
+#include "topology.hpp"
+
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+namespace lab4 {
+
+namespace {
+
+int hardware_threads() {
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<int>(hw);
+}
+
+double ns_per_char(const BenchResult& r) {
+    const auto chars = static_cast<double>(total_chars(r.race));
+    return chars > 0 ? r.summary.median / chars : 0;
+}
+
+void context_switches(std::ostream& out, const PerfSample& perf, int width) {
+    if (perf.has(PerfEvent::context_switches)) {
+        out << std::setw(width) << std::setprecision(0) << perf.get(PerfEvent::context_switches);
+    } else {
+        out << std::setw(width) << "n/a";
+    }
+}
+
+} // namespace
+
+CpuHogs::CpuHogs(int count, const std::vector<int>& cpus) {
+    threads_.reserve(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        threads_.emplace_back([this, i, cpus] {
+            pin_by_order(cpus, i);
+            while (!stop_.load(std::memory_order_relaxed)) {
+            }
+        });
+    }
+}
+
+CpuHogs::~CpuHogs() {
+    stop_.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+double StressResult::slowdown() const {
+    const double quiet_ns = ns_per_char(quiet);
+    return quiet_ns > 0 ? ns_per_char(stressed) / quiet_ns : 0;
+}
+
+double StressResult::stalls_per_run() const {
+    const auto runs = static_cast<double>(stressed.summary.samples);
+    return runs > 0 ? static_cast<double>(stressed.contention.hold_ns.count_at_least(holder_stall_ns)) / runs : 0;
+}
+
+std::vector<StressResult> run_stress(const std::vector<const PrimitiveCase*>& cases, const RaceConfig& race,
+                                     const BenchConfig& bench, const StressConfig& stress) {
+    if (stress.oversubscription < 1 || stress.hogs < 0) {
+        throw std::invalid_argument("oversubscription must be positive and hogs non-negative");
+    }
+    RaceConfig quiet = race;
+    quiet.threads = hardware_threads();
+    quiet.contention = true;
+    quiet.perf = true;
+    RaceConfig stressed = quiet;
+    stressed.threads = quiet.threads * stress.oversubscription;
+
+    std::vector<StressResult> results;
+    for (const PrimitiveCase* c : cases) {
+        StressResult result;
+        result.hogs = stress.hogs;
+        result.quiet = run_benchmark(*c, quiet, bench);
+        {
+            CpuHogs hogs(stress.hogs, race.cpus);
+            result.stressed = run_benchmark(*c, stressed, bench);
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+void print_stress(std::ostream& out, const std::vector<StressResult>& results) {
+    if (results.empty()) {
+        return;
+    }
+    const auto flags = out.flags();
+    out << "quiet: " << results.front().quiet.race.threads << " threads; stressed: "
+        << results.front().stressed.race.threads << " threads + " << results.front().hogs
+        << " CPU hogs; a stall is a hold >= " << holder_stall_ns / 1000 << " us\n"
+        << std::left << std::setw(20) << "primitive" << std::right << std::setw(13) << "quiet ns/ch"
+        << std::setw(14) << "stress ns/ch" << std::setw(10) << "slowdown" << std::setw(12)
+        << "stalls/run" << std::setw(14) << "max hold us" << std::setw(12) << "ctx-sw" << '\n';
+    out << std::fixed;
+    for (const auto& r : results) {
+        out << std::left << std::setw(20) << r.quiet.primitive << std::right << std::setprecision(1)
+            << std::setw(13) << ns_per_char(r.quiet) << std::setw(14) << ns_per_char(r.stressed)
+            << std::setprecision(2) << std::setw(9) << r.slowdown() << 'x' << std::setprecision(1)
+            << std::setw(12) << r.stalls_per_run() << std::setw(14)
+            << static_cast<double>(r.stressed.contention.hold_ns.max()) / 1e3;
+        context_switches(out, r.stressed.perf, 12);
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_stress_csv(std::ostream& out, const std::vector<StressResult>& results) {
+    out << "primitive,quiet_threads,stressed_threads,hogs,quiet_ns_per_char,stressed_ns_per_char,"
+           "slowdown,stalls_per_run,max_hold_ns,stressed_context_switches\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    for (const auto& r : results) {
+        out << r.quiet.primitive << ',' << r.quiet.race.threads << ',' << r.stressed.race.threads << ','
+            << r.hogs << ',' << ns_per_char(r.quiet) << ',' << ns_per_char(r.stressed) << ','
+            << r.slowdown() << ',' << r.stalls_per_run() << ',' << r.stressed.contention.hold_ns.max()
+            << ',';
+        if (r.stressed.perf.has(PerfEvent::context_switches)) {
+            out << r.stressed.perf.get(PerfEvent::context_switches);
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_stress_json(std::ostream& out, const std::vector<StressResult>& results) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "{\n  \"holder_stall_ns\": " << holder_stall_ns << ",\n  \"stress\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const StressResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(r.quiet.primitive)
+            << "\", \"quiet_threads\": " << r.quiet.race.threads
+            << ", \"stressed_threads\": " << r.stressed.race.threads << ", \"hogs\": " << r.hogs
+            << ", \"quiet_ns_per_char\": " << ns_per_char(r.quiet)
+            << ", \"stressed_ns_per_char\": " << ns_per_char(r.stressed) << ", \"slowdown\": " << r.slowdown()
+            << ", \"stalls_per_run\": " << r.stalls_per_run()
+            << ", \"max_hold_ns\": " << r.stressed.contention.hold_ns.max()
+            << ", \"quiet_raw_ns\": [";
+        for (std::size_t j = 0; j < r.quiet.samples_ns.size(); ++j) {
+            out << (j == 0 ? "" : ", ") << r.quiet.samples_ns[j];
+        }
+        out << "], \"stressed_raw_ns\": [";
+        for (std::size_t j = 0; j < r.stressed.samples_ns.size(); ++j) {
+            out << (j == 0 ? "" : ", ") << r.stressed.samples_ns[j];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
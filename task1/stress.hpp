@@ -0,0 +1,62 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <thread>
+#include <vector>
+
+namespace lab4 {
+
+// Spinning locks next to the blocking primitives they are meant to beat.
+inline constexpr const char* stress_default =
+    "spinlock,spinwait-spin,spinwait,mutex,futex-mutex,semaphore,monitor";
+
+// A lock held this long was not running its critical section (a character
+// takes tens of ns): the holder was preempted while everybody else waited.
+inline constexpr std::uint64_t holder_stall_ns = 50000;
+
+struct StressConfig {
+    int oversubscription = 2; // racers per hardware thread in the stressed run
+    int hogs = 0;             // background threads burning CPU during the stressed run
+};
+
+// Busy-looping threads that compete with the racers for the CPU until they
+// are destroyed. Pinned like the racers when cpus is not empty.
+class CpuHogs {
+public:
+    CpuHogs(int count, const std::vector<int>& cpus);
+    ~CpuHogs();
+
+    CpuHogs(const CpuHogs&) = delete;
+    CpuHogs& operator=(const CpuHogs&) = delete;
+
+private:
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> threads_;
+};
+
+// One primitive with one racer per hardware thread on a quiet machine, and
+// then oversubscribed with the hogs running.
+struct StressResult {
+    BenchResult quiet;
+    BenchResult stressed;
+    int hogs = 0;
+
+    // Time per character stressed over time per character quiet.
+    double slowdown() const;
+    // Holds of at least holder_stall_ns per stressed run.
+    double stalls_per_run() const;
+};
+
+// Turns contention recording on for both runs: stalls come from the hold histogram.
+std::vector<StressResult> run_stress(const std::vector<const PrimitiveCase*>& cases, const RaceConfig& race,
+                                     const BenchConfig& bench, const StressConfig& stress);
+
+void print_stress(std::ostream& out, const std::vector<StressResult>& results);
+void write_stress_csv(std::ostream& out, const std::vector<StressResult>& results);
+void write_stress_json(std::ostream& out, const std::vector<StressResult>& results);
+
+} // namespace lab4
@@ -0,0 +1,106 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+namespace lab4 {
+
+int SweepCurve::knee() const {
+    int best = 0;
+    double best_throughput = -1;
+    for (const auto& p : points) {
+        if (p.bench.throughput() > best_throughput) {
+            best_throughput = p.bench.throughput();
+            best = p.bench.race.threads;
+        }
+    }
+    return best;
+}
+
+int default_max_threads() {
+    const unsigned hw = std::thread::hardware_concurrency();
+    return 2 * static_cast<int>(std::max(hw, 1u));
+}
+
+SweepCurve run_sweep(const PrimitiveCase& primitive, const RaceConfig& race,
+                     const BenchConfig& bench, int max_threads) {
+    if (max_threads < 1) {
+        throw std::invalid_argument("sweep needs at least one thread");
+    }
+
+    SweepCurve curve;
+    curve.primitive = primitive.name;
+    double base = 0;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        RaceConfig cfg = race;
+        cfg.threads = threads;
+        SweepPoint point;
+        point.bench = run_benchmark(primitive, cfg, bench);
+        if (threads == 1) {
+            base = point.bench.throughput();
+        }
+        point.speedup = base > 0 ? point.bench.throughput() / base : 0;
+        point.efficiency = point.speedup / threads;
+        curve.points.push_back(std::move(point));
+    }
+    return curve;
+}
+
+void print_sweep(std::ostream& out, const std::vector<SweepCurve>& curves) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    for (const auto& curve : curves) {
+        out << "== " << curve.primitive << " (knee at " << curve.knee() << " threads)\n";
+        out << std::setw(8) << "threads" << std::setw(12) << "median ms" << std::setw(14)
+            << "Mchar/s" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << '\n';
+        for (const auto& p : curve.points) {
+            out << std::setw(8) << p.bench.race.threads << std::setw(12)
+                << p.bench.summary.median / 1e6 << std::setw(14) << p.bench.throughput() / 1e6
+                << std::setw(10) << p.speedup << std::setw(12) << p.efficiency << '\n';
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_sweep_csv(std::ostream& out, const std::vector<SweepCurve>& curves) {
+    out << "primitive,threads,chars,kept,median_ns,p90_ns,p99_ns,chars_per_sec,speedup,efficiency\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(4);
+    for (const auto& curve : curves) {
+        for (const auto& p : curve.points) {
+            const Summary& s = p.bench.summary;
+            out << curve.primitive << ',' << p.bench.race.threads << ',' << p.bench.race.chars << ','
+                << s.kept << ',' << s.median << ',' << s.p90 << ',' << s.p99 << ','
+                << p.bench.throughput() << ',' << p.speedup << ',' << p.efficiency << '\n';
+        }
+    }
+    out.flags(flags);
+}
+
+void write_sweep_json(std::ostream& out, const std::vector<SweepCurve>& curves, const BenchConfig& bench) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"warmup\": " << bench.warmup << ",\n  \"iterations\": " << bench.iterations
+        << ",\n  \"curves\": [";
+    for (std::size_t i = 0; i < curves.size(); ++i) {
+        const SweepCurve& curve = curves[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(curve.primitive)
+            << "\", \"knee_threads\": " << curve.knee() << ", \"points\": [";
+        for (std::size_t j = 0; j < curve.points.size(); ++j) {
+            const SweepPoint& p = curve.points[j];
+            out << (j == 0 ? "\n" : ",\n") << "      {\"threads\": " << p.bench.race.threads
+                << ", \"median_ns\": " << p.bench.summary.median << ", \"p90_ns\": "
+                << p.bench.summary.p90 << ", \"chars_per_sec\": " << p.bench.throughput()
+                << ", \"speedup\": " << p.speedup << ", \"efficiency\": " << p.efficiency << "}";
+        }
+        out << "\n    ]}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+struct SweepPoint {
+    BenchResult bench;
+    double speedup = 0;    // throughput relative to the single-thread run
+    double efficiency = 0; // speedup divided by the number of threads
+};
+
+struct SweepCurve {
+    std::string primitive;
+    std::vector<SweepPoint> points; // one point per thread count, ascending
+
+    // Thread count with the best throughput: past it the primitive stops scaling.
+    int knee() const;
+};
+
+// Upper end of the sweep when none is given: twice the hardware threads, so
+// the oversubscribed half of the curve is always covered.
+int default_max_threads();
+
+// Benchmarks the primitive once for every thread count in [1, max_threads].
+SweepCurve run_sweep(const PrimitiveCase& primitive, const RaceConfig& race,
+                     const BenchConfig& bench, int max_threads);
+
+void print_sweep(std::ostream& out, const std::vector<SweepCurve>& curves);
+void write_sweep_csv(std::ostream& out, const std::vector<SweepCurve>& curves);
+void write_sweep_json(std::ostream& out, const std::vector<SweepCurve>& curves, const BenchConfig& bench);
+
+} // namespace lab4
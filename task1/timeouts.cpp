@@ -0,0 +1,381 @@
+#include "timeouts.hpp"
+
+#include "bench.hpp"
+#include "cohort_lock.hpp"
+#include "futex_sync.hpp"
+#include "monitor.hpp"
+#include "primitives.hpp"
+#include "pthread_sync.hpp"
+#include "queue_locks.hpp"
+#include "spin_wait.hpp"
+#include "stopwatch.hpp"
+#include "topology.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <semaphore>
+#include <sstream>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+
+namespace lab4 {
+
+namespace {
+
+std::int64_t thread_cpu_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Runs cfg.waits timed waits on a pinned thread. wait(deadline) must fail:
+// returning true means the primitive was acquired, which cannot happen here.
+template <class TimedWait>
+void measure_timed(const TimeoutConfig& cfg, TimeoutSamples& samples, TimedWait wait) {
+    const auto timeout = std::chrono::microseconds(cfg.timeout_us);
+    bool acquired = false;
+    std::thread waiter([&] {
+        pin_by_order(cfg.cpus, 0);
+        for (std::size_t i = 0; i < cfg.waits; ++i) {
+            const Deadline deadline = std::chrono::steady_clock::now() + timeout;
+            const std::int64_t cpu = thread_cpu_ns();
+            acquired = wait(deadline) || acquired;
+            const auto back = std::chrono::steady_clock::now();
+            samples.cpu_ns.push_back(thread_cpu_ns() - cpu);
+            samples.overshoot_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(back - deadline).count());
+        }
+    });
+    waiter.join();
+    if (acquired) {
+        throw std::logic_error("a timed wait acquired a primitive nobody released");
+    }
+}
+
+// A cancelled waiter still asleep this long after request_stop() lost the
+// request; with no deadline it would sleep forever, so the run aborts.
+constexpr std::chrono::seconds lost_stop_after{2};
+
+// Parks a pinned waiter with a fresh stop token cfg.waits times, lets it
+// sleep for timeout_us and measures how long request_stop() takes to get it
+// back. The stop comes from a pinned canceller thread, so the caller keeps
+// its own affinity.
+template <class StopWait>
+void measure_cancels(const TimeoutConfig& cfg, TimeoutSamples& samples, StopWait wait) {
+    bool acquired = false;
+    std::thread canceller([&] {
+        pin_by_order(cfg.cpus, 1);
+        for (std::size_t i = 0; i < cfg.waits; ++i) {
+            std::stop_source source;
+            std::atomic<std::int64_t> returned{0};
+            std::thread waiter([&] {
+                pin_by_order(cfg.cpus, 0);
+                acquired = wait(source.get_token()) || acquired;
+                returned.store(StopWatch::now_ns(), std::memory_order_release);
+            });
+            std::this_thread::sleep_for(std::chrono::microseconds(cfg.timeout_us));
+            const std::int64_t requested = StopWatch::now_ns();
+            source.request_stop();
+            const auto give_up = std::chrono::steady_clock::now() + lost_stop_after;
+            while (returned.load(std::memory_order_acquire) == 0) {
+                if (std::chrono::steady_clock::now() >= give_up) {
+                    std::fputs("fatal: a stop request was lost, the cancelled waiter is still asleep\n", stderr);
+                    std::abort();
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            waiter.join();
+            samples.cancel_ns.push_back(returned.load(std::memory_order_acquire) - requested);
+        }
+    });
+    canceller.join();
+    if (acquired) {
+        throw std::logic_error("a cancelled wait acquired a primitive nobody released");
+    }
+}
+
+// Locks with try_lock_until() and, when they have it, lock(std::stop_token).
+// The lock is taken on the calling thread and never released during the run.
+template <class Lock, bool Cancellable = true>
+TimeoutSamples lock_timeouts(const TimeoutConfig& cfg) {
+    Lock lock;
+    lock.lock();
+    TimeoutSamples samples;
+    measure_timed(cfg, samples, [&lock](Deadline deadline) { return lock.try_lock_until(deadline); });
+    if constexpr (Cancellable) {
+        measure_cancels(cfg, samples, [&lock](std::stop_token stop) { return lock.lock(stop); });
+    }
+    lock.unlock();
+    return samples;
+}
+
+constexpr int crowd_size = 3;
+constexpr std::chrono::microseconds crowd_timeout{20};
+
+// lock_timeouts with crowd_size more threads retrying short timed waits on
+// the held lock the whole time, so the lock word keeps being rewritten while
+// the measured waiter goes to sleep and its stop request arrives.
+template <class Lock>
+TimeoutSamples crowded_lock_timeouts(const TimeoutConfig& cfg) {
+    Lock lock;
+    lock.lock();
+    std::atomic<bool> done{false};
+    std::atomic<bool> acquired{false};
+    std::vector<std::thread> crowd;
+    for (int i = 0; i < crowd_size; ++i) {
+        crowd.emplace_back([&, i] {
+            pin_by_order(cfg.cpus, 2 + i);
+            while (!done.load(std::memory_order_relaxed)) {
+                if (lock.try_lock_for(crowd_timeout)) {
+                    acquired.store(true, std::memory_order_relaxed);
+                    lock.unlock();
+                }
+            }
+        });
+    }
+    auto disperse = [&] {
+        done.store(true, std::memory_order_relaxed);
+        for (auto& thread : crowd) {
+            thread.join();
+        }
+        lock.unlock();
+    };
+    TimeoutSamples samples;
+    try {
+        measure_timed(cfg, samples, [&lock](Deadline deadline) { return lock.try_lock_until(deadline); });
+        measure_cancels(cfg, samples, [&lock](std::stop_token stop) { return lock.lock(stop); });
+    } catch (...) {
+        disperse();
+        throw;
+    }
+    disperse();
+    if (acquired.load(std::memory_order_relaxed)) {
+        throw std::logic_error("a crowd thread acquired a lock nobody released");
+    }
+    return samples;
+}
+
+template <class Semaphore, bool Cancellable = true>
+TimeoutSamples semaphore_timeouts(const TimeoutConfig& cfg) {
+    Semaphore sem(0);
+    TimeoutSamples samples;
+    measure_timed(cfg, samples, [&sem](Deadline deadline) { return sem.try_acquire_until(deadline); });
+    if constexpr (Cancellable) {
+        measure_cancels(cfg, samples, [&sem](std::stop_token stop) { return sem.acquire(stop); });
+    }
+    return samples;
+}
+
+// Monitor.Wait with nobody to pulse; a successful wait means a pulse came
+// from nowhere, or a spurious condition_variable wake-up for monitor-cv.
+template <class Monitor>
+TimeoutSamples monitor_timeouts(const TimeoutConfig& cfg) {
+    Monitor monitor;
+    TimeoutSamples samples;
+    measure_timed(cfg, samples, [&monitor](Deadline deadline) {
+        std::lock_guard<Monitor> guard(monitor);
+        return monitor.wait_until(deadline);
+    });
+    measure_cancels(cfg, samples, [&monitor](std::stop_token stop) {
+        std::lock_guard<Monitor> guard(monitor);
+        return monitor.wait(std::move(stop));
+    });
+    return samples;
+}
+
+constexpr std::chrono::microseconds poll_period{50};
+
+// What a timeout looks like without kernel help: try_lock in a loop that
+// either yields (burns the CPU) or sleeps a fixed period (reacts late).
+template <bool Sleep>
+TimeoutSamples polling_timeouts(const TimeoutConfig& cfg) {
+    FutexMutex lock;
+    lock.lock();
+    auto pause = [] {
+        if constexpr (Sleep) {
+            std::this_thread::sleep_for(poll_period);
+        } else {
+            std::this_thread::yield();
+        }
+    };
+    TimeoutSamples samples;
+    measure_timed(cfg, samples, [&](Deadline deadline) {
+        while (!lock.try_lock()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            pause();
+        }
+        return true;
+    });
+    measure_cancels(cfg, samples, [&](std::stop_token stop) {
+        while (!lock.try_lock()) {
+            if (stop.stop_requested()) {
+                return false;
+            }
+            pause();
+        }
+        return true;
+    });
+    lock.unlock();
+    return samples;
+}
+
+} // namespace
+
+const std::vector<TimeoutCase>& timeout_cases() {
+    static const std::vector<TimeoutCase> cases = {
+        {"futex-mutex", "FutexMutex, futex deadline + stop poke", lock_timeouts<FutexMutex>},
+        {"futex-mutex-crowd", "FutexMutex with 3 more threads retrying 20 us timed waits",
+         crowded_lock_timeouts<FutexMutex>},
+        {"spinwait", "adaptive SpinWait lock, spins then parks with the deadline",
+         lock_timeouts<SpinWaitLock<>>},
+        {"spinwait-spin", "SpinWait lock that only spins, polls the clock",
+         lock_timeouts<SpinWaitLock<WaitStrategy::spin>>},
+        {"spinlock", "test-and-set spin lock, polls the clock", lock_timeouts<SpinLock>},
+        {"ticket", "ticket lock, try_lock until the deadline, no ticket taken", lock_timeouts<TicketLock>},
+        {"cohort", "cohort lock, try_lock until the deadline, no ticket taken", lock_timeouts<CohortLock>},
+        {"futex-semaphore", "FutexSemaphore, wake sequence with deadline", semaphore_timeouts<FutexSemaphore>},
+        {"monitor", "Monitor.Wait(timeout), per-waiter futex", monitor_timeouts<Monitor>},
+        {"monitor-cv", "Monitor.Wait(timeout), condition_variable + stop callback",
+         monitor_timeouts<CondVarMonitor>},
+        {"pthread-mutex", "pthread_mutex_clocklock", lock_timeouts<PthreadMutex<>, false>},
+        {"posix-semaphore", "sem_clockwait", semaphore_timeouts<PosixSemaphore, false>},
+        {"timed-mutex", "std::timed_mutex::try_lock_until", lock_timeouts<std::timed_mutex, false>},
+        {"semaphore", "std::counting_semaphore::try_acquire_until",
+         semaphore_timeouts<std::counting_semaphore<>, false>},
+        {"poll-yield", "try_lock + yield until the deadline or stop", polling_timeouts<false>},
+        {"poll-sleep", "try_lock + 50 us sleep until the deadline or stop", polling_timeouts<true>},
+    };
+    return cases;
+}
+
+std::vector<const TimeoutCase*> select_timeout_cases(const std::string& filter) {
+    const auto& cases = timeout_cases();
+    std::vector<const TimeoutCase*> selected;
+    if (filter.empty()) {
+        for (const auto& c : cases) {
+            selected.push_back(&c);
+        }
+        return selected;
+    }
+
+    std::istringstream names(filter);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        if (name.empty()) {
+            continue;
+        }
+        const TimeoutCase* found = nullptr;
+        for (const auto& c : cases) {
+            if (c.name == name) {
+                found = &c;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            throw std::invalid_argument("no timed wait for primitive: " + name);
+        }
+        selected.push_back(found);
+    }
+    return selected;
+}
+
+TimeoutResult run_timeouts(const TimeoutCase& c, const TimeoutConfig& cfg) {
+    if (cfg.waits == 0) {
+        throw std::invalid_argument("timeouts need at least one wait");
+    }
+    const TimeoutSamples samples = c.run(cfg);
+    std::vector<double> overshoot(samples.overshoot_ns.begin(), samples.overshoot_ns.end());
+    std::sort(overshoot.begin(), overshoot.end());
+    std::vector<double> cancel(samples.cancel_ns.begin(), samples.cancel_ns.end());
+    std::sort(cancel.begin(), cancel.end());
+    double cpu = 0;
+    for (std::int64_t ns : samples.cpu_ns) {
+        cpu += static_cast<double>(ns);
+    }
+
+    TimeoutResult r;
+    r.primitive = c.name;
+    r.waits = overshoot.size();
+    r.overshoot_p50 = percentile(overshoot, 0.5);
+    r.overshoot_p99 = percentile(overshoot, 0.99);
+    r.overshoot_max = overshoot.back();
+    r.cpu_per_wait = cpu / static_cast<double>(samples.cpu_ns.size());
+    r.cancellable = !cancel.empty();
+    if (r.cancellable) {
+        r.cancel_p50 = percentile(cancel, 0.5);
+        r.cancel_p99 = percentile(cancel, 0.99);
+    }
+    return r;
+}
+
+void print_timeouts(std::ostream& out, const std::vector<TimeoutResult>& results) {
+    const auto flags = out.flags();
+    out << "deadline overshoot, waiter CPU per timed wait and stop latency (us):\n"
+        << std::left << std::setw(18) << "primitive" << std::right << std::setw(7) << "waits"
+        << std::setw(11) << "over p50" << std::setw(11) << "over p99" << std::setw(11) << "over max"
+        << std::setw(11) << "cpu/wait" << std::setw(13) << "cancel p50" << std::setw(13) << "cancel p99"
+        << '\n';
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        out << std::left << std::setw(18) << r.primitive << std::right << std::setw(7) << r.waits
+            << std::setw(11) << r.overshoot_p50 / 1e3 << std::setw(11) << r.overshoot_p99 / 1e3
+            << std::setw(11) << r.overshoot_max / 1e3 << std::setw(11) << r.cpu_per_wait / 1e3;
+        if (r.cancellable) {
+            out << std::setw(13) << r.cancel_p50 / 1e3 << std::setw(13) << r.cancel_p99 / 1e3;
+        } else {
+            out << std::setw(13) << "n/a" << std::setw(13) << "n/a";
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_timeouts_csv(std::ostream& out, const std::vector<TimeoutResult>& results) {
+    out << "primitive,waits,overshoot_p50_ns,overshoot_p99_ns,overshoot_max_ns,cpu_per_wait_ns,"
+           "cancel_p50_ns,cancel_p99_ns\n";
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        out << r.primitive << ',' << r.waits << ',' << r.overshoot_p50 << ',' << r.overshoot_p99 << ','
+            << r.overshoot_max << ',' << r.cpu_per_wait << ',';
+        if (r.cancellable) {
+            out << r.cancel_p50 << ',' << r.cancel_p99;
+        } else {
+            out << ',';
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+void write_timeouts_json(std::ostream& out, const std::vector<TimeoutResult>& results) {
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"timeouts\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const TimeoutResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"primitive\": \"" << json_escape(r.primitive)
+            << "\", \"waits\": " << r.waits << ", \"overshoot_p50_ns\": " << r.overshoot_p50
+            << ", \"overshoot_p99_ns\": " << r.overshoot_p99 << ", \"overshoot_max_ns\": " << r.overshoot_max
+            << ", \"cpu_per_wait_ns\": " << r.cpu_per_wait << ", \"cancel_p50_ns\": ";
+        if (r.cancellable) {
+            out << r.cancel_p50 << ", \"cancel_p99_ns\": " << r.cancel_p99;
+        } else {
+            out << "null, \"cancel_p99_ns\": null";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+} // namespace lab4
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+struct TimeoutConfig {
+    std::uint64_t timeout_us = 200; // deadline of every timed wait, and how long a cancelled waiter sleeps
+    std::size_t waits = 200;        // timed waits and cancellations per primitive
+    std::vector<int> cpus;          // pinning of the waiter and the canceller, as in RaceConfig
+};
+
+// A wait nobody ends: the primitive is held (or has no permits, or is never
+// pulsed) for the whole run, so every timed wait runs into its deadline and
+// every cancellable wait ends by a stop request.
+struct TimeoutSamples {
+    std::vector<std::int64_t> overshoot_ns; // return time minus deadline, per timed wait
+    std::vector<std::int64_t> cpu_ns;       // waiter's CPU time per timed wait
+    std::vector<std::int64_t> cancel_ns;    // request_stop() to return, empty without stop_token waits
+};
+
+struct TimeoutCase {
+    std::string name;
+    std::string description;
+    std::function<TimeoutSamples(const TimeoutConfig&)> run;
+};
+
+struct TimeoutResult {
+    std::string primitive;
+    std::size_t waits = 0;
+    double overshoot_p50 = 0;
+    double overshoot_p99 = 0;
+    double overshoot_max = 0;
+    double cpu_per_wait = 0; // mean; near zero unless the wait polls
+    bool cancellable = false;
+    double cancel_p50 = 0;
+    double cancel_p99 = 0;
+};
+
+const std::vector<TimeoutCase>& timeout_cases();
+
+// Same filter syntax as select_cases().
+std::vector<const TimeoutCase*> select_timeout_cases(const std::string& filter);
+
+TimeoutResult run_timeouts(const TimeoutCase& c, const TimeoutConfig& cfg);
+
+void print_timeouts(std::ostream& out, const std::vector<TimeoutResult>& results);
+void write_timeouts_csv(std::ostream& out, const std::vector<TimeoutResult>& results);
+void write_timeouts_json(std::ostream& out, const std::vector<TimeoutResult>& results);
+
+} // namespace lab4
@@ -0,0 +1,223 @@
+#include "topology.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace lab4 {
+
+namespace {
+
+const std::string sysfs_cpu = "/sys/devices/system/cpu/";
+const std::string sysfs_node = "/sys/devices/system/node/";
+
+std::atomic<std::size_t> failed_pins{0};
+
+bool read_line(const std::string& path, std::string& line) {
+    std::ifstream in(path);
+    return static_cast<bool>(std::getline(in, line));
+}
+
+// CPUs the process may run on, e.g. inside a cpuset cgroup or under taskset.
+bool allowed_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof set, &set) != 0) {
+        return true; // nothing to check against; a refused pin is still counted
+    }
+    return cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+}
+
+int read_int(const std::string& path, int fallback) {
+    std::string line;
+    if (!read_line(path, line)) {
+        return fallback;
+    }
+    try {
+        return std::stoi(line);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+} // namespace
+
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::istringstream parts(list);
+    std::string part;
+    while (std::getline(parts, part, ',')) {
+        if (part.empty()) {
+            continue;
+        }
+        try {
+            const auto dash = part.find('-');
+            const int first = std::stoi(part.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+            if (first < 0 || last < first) {
+                throw std::invalid_argument(part);
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            throw std::invalid_argument("bad CPU list element '" + part + "'");
+        }
+    }
+    return cpus;
+}
+
+std::vector<CpuInfo> read_topology() {
+    std::string online;
+    std::vector<int> ids;
+    if (read_line(sysfs_cpu + "online", online)) {
+        ids = parse_cpu_list(online);
+    } else {
+        for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); ++cpu) {
+            ids.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    // Node ids can be sparse (e.g. 0 and 2 on a machine with a node
+    // offline), so walk the kernel's list instead of counting up from 0.
+    std::map<int, int> node_of;
+    std::string nodes;
+    if (read_line(sysfs_node + "online", nodes)) {
+        for (int node : parse_cpu_list(nodes)) {
+            std::string list;
+            if (read_line(sysfs_node + "node" + std::to_string(node) + "/cpulist", list)) {
+                for (int cpu : parse_cpu_list(list)) {
+                    node_of[cpu] = node;
+                }
+            }
+        }
+    }
+
+    std::vector<CpuInfo> topology;
+    for (int id : ids) {
+        const std::string dir = sysfs_cpu + "cpu" + std::to_string(id) + "/topology/";
+        CpuInfo info;
+        info.cpu = id;
+        info.core = read_int(dir + "core_id", id);
+        info.package = read_int(dir + "physical_package_id", 0);
+        info.node = node_of.count(id) != 0 ? node_of[id] : 0;
+        std::string siblings;
+        if (read_line(dir + "thread_siblings_list", siblings)) {
+            const std::vector<int> smt = parse_cpu_list(siblings);
+            info.smt = static_cast<int>(std::find(smt.begin(), smt.end(), id) - smt.begin());
+        }
+        topology.push_back(info);
+    }
+    return topology;
+}
+
+std::vector<int> placement_order(Placement placement, const std::vector<CpuInfo>& topology,
+                                 const std::string& list) {
+    std::vector<int> order;
+    switch (placement) {
+    case Placement::none:
+        break;
+
+    case Placement::compact: {
+        std::vector<CpuInfo> cpus = topology;
+        std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+            return std::tie(a.node, a.package, a.core, a.smt, a.cpu) <
+                   std::tie(b.node, b.package, b.core, b.smt, b.cpu);
+        });
+        for (const auto& c : cpus) {
+            order.push_back(c.cpu);
+        }
+        break;
+    }
+
+    case Placement::scatter: {
+        // One queue per (node, package), each listing first siblings of all
+        // cores, then second siblings; then take one CPU from each in turn.
+        std::map<std::pair<int, int>, std::vector<CpuInfo>> domains;
+        for (const auto& c : topology) {
+            domains[{c.node, c.package}].push_back(c);
+        }
+        std::vector<std::vector<CpuInfo>> queues;
+        for (auto& [key, cpus] : domains) {
+            std::sort(cpus.begin(), cpus.end(), [](const CpuInfo& a, const CpuInfo& b) {
+                return std::tie(a.smt, a.core, a.cpu) < std::tie(b.smt, b.core, b.cpu);
+            });
+            queues.push_back(std::move(cpus));
+        }
+        for (std::size_t i = 0; order.size() < topology.size(); ++i) {
+            for (const auto& queue : queues) {
+                if (i < queue.size()) {
+                    order.push_back(queue[i].cpu);
+                }
+            }
+        }
+        break;
+    }
+
+    case Placement::list:
+        order = parse_cpu_list(list);
+        for (int cpu : order) {
+            const bool online = std::any_of(topology.begin(), topology.end(),
+                                            [cpu](const CpuInfo& c) { return c.cpu == cpu; });
+            if (!online) {
+                throw std::invalid_argument("CPU " + std::to_string(cpu) + " is not online");
+            }
+        }
+        if (order.empty()) {
+            throw std::invalid_argument("empty CPU list");
+        }
+        break;
+    }
+    return order;
+}
+
+std::vector<int> resolve_placement(const std::string& spec) {
+    if (spec.empty() || spec == "none") {
+        return {};
+    }
+    std::vector<CpuInfo> topology = read_topology();
+    if (spec != "compact" && spec != "scatter") {
+        std::vector<int> order = placement_order(Placement::list, topology, spec);
+        for (int cpu : order) {
+            if (!allowed_cpu(cpu)) {
+                throw std::invalid_argument("CPU " + std::to_string(cpu) + " is outside the process's affinity mask");
+            }
+        }
+        return order;
+    }
+    topology.erase(std::remove_if(topology.begin(), topology.end(),
+                                  [](const CpuInfo& c) { return !allowed_cpu(c.cpu); }),
+                   topology.end());
+    if (topology.empty()) {
+        throw std::invalid_argument("no online CPU in the process's affinity mask");
+    }
+    return placement_order(spec == "compact" ? Placement::compact : Placement::scatter, topology);
+}
+
+bool pin_current_thread(int cpu) noexcept {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool pinned = false;
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &set);
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+    }
+    if (!pinned) {
+        failed_pins.fetch_add(1, std::memory_order_relaxed);
+    }
+    return pinned;
+}
+
+std::size_t pin_failures() noexcept {
+    return failed_pins.load(std::memory_order_relaxed);
+}
+
+} // namespace lab4
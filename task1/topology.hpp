@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lab4 {
+
+// One online logical CPU as described by sysfs.
+struct CpuInfo {
+    int cpu = 0;
+    int core = 0;    // topology/core_id, unique within a package
+    int package = 0; // socket
+    int node = 0;    // NUMA node
+    int smt = 0;     // position among the hyper-thread siblings of its core
+};
+
+// Online CPUs sorted by id, read from /sys/devices/system/{cpu,node}. Falls
+// back to one flat package when sysfs is not available.
+std::vector<CpuInfo> read_topology();
+
+// Parses a kernel CPU list such as "0-3,8,10-11".
+std::vector<int> parse_cpu_list(const std::string& list);
+
+enum class Placement {
+    none,    // leave the threads to the scheduler
+    compact, // fill a core's SMT siblings, then the next core of the same package
+    scatter, // spread across packages and NUMA nodes, physical cores before siblings
+    list,    // explicit CPU list
+};
+
+// CPU of thread i is the i-th element (modulo size). Empty for Placement::none.
+// Throws std::invalid_argument when an explicit CPU is not online.
+std::vector<int> placement_order(Placement placement, const std::vector<CpuInfo>& topology,
+                                 const std::string& list = {});
+
+// Parses "none", "compact", "scatter" or a CPU list into an order of CPUs.
+// Only CPUs in the process's affinity mask are used; an explicit list naming
+// another one throws std::invalid_argument.
+std::vector<int> resolve_placement(const std::string& spec);
+
+// Pins the calling thread to one CPU; returns false if the kernel refused,
+// which is also counted in pin_failures().
+bool pin_current_thread(int cpu) noexcept;
+
+// Pins the calling thread i according to an order from placement_order().
+inline bool pin_by_order(const std::vector<int>& order, int i) noexcept {
+    return order.empty() || pin_current_thread(order[static_cast<std::size_t>(i) % order.size()]);
+}
+
+// Threads that asked to be pinned and kept running wherever the scheduler
+// put them, over the whole process.
+std::size_t pin_failures() noexcept;
+
+} // namespace lab4